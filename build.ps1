@@ -1,5 +1,5 @@
 # PowerShell build script for BlackJack-OS
-# Usage: .\build.ps1 [clean|all|server|client]
+# Usage: .\build.ps1 [clean|all|server|client|loadgen|sim|jdump|replay|bench]
 
 param(
     [Parameter(Position=0)]
@@ -10,9 +10,46 @@ $CC = "gcc"
 $CFLAGS = "-std=c11 -Wall -Wextra -pthread -g"
 $LDFLAGS = ""
 
+# frame.c, deck.c, rng.c and rules.c, linked into every program
+function Build-Lib {
+    if (Test-Path libbj.a) { return }
+    Write-Host "Building libbj.a..." -ForegroundColor Green
+    foreach ($src in "frame.c","deck.c","rng.c","rules.c") {
+        & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -c -o ($src -replace '\.c$','.o') $src
+        if ($LASTEXITCODE -ne 0) {
+            Write-Host "libbj.a build failed!" -ForegroundColor Red
+            exit 1
+        }
+    }
+    & ar rcs libbj.a frame.o deck.o rng.o rules.o
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "libbj.a build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+# Basic strategy and dealer odds (strategy.h), generated once; clean to redo
+function Build-Tables {
+    Build-Lib
+    if (Test-Path strategy_tables.c) { return }
+    Write-Host "Generating strategy tables..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o gentables.exe gentables.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "gentables build failed!" -ForegroundColor Red
+        exit 1
+    }
+    & .\gentables.exe strategy_tables.c
+    if ($LASTEXITCODE -ne 0) {
+        Remove-Item -Path strategy_tables.c -ErrorAction SilentlyContinue
+        Write-Host "gentables failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
 function Build-Server {
+    Build-Tables
     Write-Host "Building server..." -ForegroundColor Green
-    & $CC -std=c11 -Wall -Wextra -pthread -g -o server.exe server.c
+    & $CC -std=c11 -Wall -Wextra -pthread -g -o server.exe server.c table.c timer.c mailbox.c qsbr.c stats.c hist.c journal.c ledger.c strategy_tables.c libbj.a
     if ($LASTEXITCODE -eq 0) {
         Write-Host "Server built successfully!" -ForegroundColor Green
     } else {
@@ -22,8 +59,9 @@ function Build-Server {
 }
 
 function Build-Client {
+    Build-Lib
     Write-Host "Building client..." -ForegroundColor Green
-    & $CC -std=c11 -Wall -Wextra -pthread -g -o client.exe client.c
+    & $CC -std=c11 -Wall -Wextra -pthread -g -o client.exe client.c libbj.a
     if ($LASTEXITCODE -eq 0) {
         Write-Host "Client built successfully!" -ForegroundColor Green
     } else {
@@ -32,9 +70,71 @@ function Build-Client {
     }
 }
 
+function Build-Loadgen {
+    Build-Tables
+    Write-Host "Building loadgen..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o loadgen.exe loadgen.c hist.c strategy_tables.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "loadgen build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Build-Sim {
+    Build-Tables
+    Write-Host "Building sim..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o sim.exe sim.c strategy_tables.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "sim build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Build-Jdump {
+    Build-Lib
+    Write-Host "Building jdump..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -o jdump.exe jdump.c journal.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "jdump build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Build-Replay {
+    Build-Tables
+    Write-Host "Building replay..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o replay.exe replay.c table.c timer.c mailbox.c stats.c hist.c journal.c ledger.c strategy_tables.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "replay build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
+function Build-Bench {
+    Build-Lib
+    Write-Host "Building rng_bench..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o rng_bench.exe rng_bench.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "rng_bench build failed!" -ForegroundColor Red
+        exit 1
+    }
+    Write-Host "Building hand_bench..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o hand_bench.exe hand_bench.c handeval.c libbj.a
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "hand_bench build failed!" -ForegroundColor Red
+        exit 1
+    }
+    Write-Host "Building micro_bench..." -ForegroundColor Green
+    & $CC -std=c11 -Wall -Wextra -pthread -g -O2 -o micro_bench.exe micro_bench.c libbj.a "-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free"
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "micro_bench build failed!" -ForegroundColor Red
+        exit 1
+    }
+}
+
 function Clean-Build {
     Write-Host "Cleaning build artifacts..." -ForegroundColor Yellow
-    Remove-Item -Path server.exe,client.exe,*.o -ErrorAction SilentlyContinue
+    Remove-Item -Path server.exe,client.exe,loadgen.exe,sim.exe,jdump.exe,replay.exe,rng_bench.exe,hand_bench.exe,micro_bench.exe,gentables.exe,strategy_tables.c,libbj.a,*.o -ErrorAction SilentlyContinue
     Write-Host "Clean complete!" -ForegroundColor Green
 }
 
@@ -48,17 +148,36 @@ switch ($Target.ToLower()) {
     "client" {
         Build-Client
     }
+    "loadgen" {
+        Build-Loadgen
+    }
+    "sim" {
+        Build-Sim
+    }
+    "jdump" {
+        Build-Jdump
+    }
+    "replay" {
+        Build-Replay
+    }
+    "bench" {
+        Build-Bench
+    }
     "all" {
         Clean-Build
         Build-Server
         Build-Client
+        Build-Loadgen
+        Build-Sim
+        Build-Jdump
+        Build-Replay
         Write-Host "`nBuild complete! You can now run:" -ForegroundColor Cyan
         Write-Host "  .\server.exe 12345" -ForegroundColor White
         Write-Host "  .\client.exe 127.0.0.1 12345 YourName" -ForegroundColor White
     }
     default {
         Write-Host "Unknown target: $Target" -ForegroundColor Red
-        Write-Host "Usage: .\build.ps1 [clean|all|server|client]" -ForegroundColor Yellow
+        Write-Host "Usage: .\build.ps1 [clean|all|server|client|loadgen|sim|jdump|replay|bench]" -ForegroundColor Yellow
         exit 1
     }
 }
@@ -1,118 +1,330 @@
 // client.c
 #include "common.h"
 #include "protocol.h"
+#include "frame.h"
+#include "deck.h"
 #include <strings.h>  // for strcasecmp, strncasecmp
 
 volatile int my_turn = 0;
 volatile int client_running = 1;
 int sockfd = -1;
+int binary_mode = 0; // JOIN_BIN was sent, frames are opcodes
+int watch_mode = 0;  // following a table as a spectator
 pthread_t reader_thread;
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sockaddr_in server_addr;
+static char session[2 * SESSION_TOKEN_LEN + 1]; // from WELCOME; empty until seated
 
-ssize_t write_all(int fd, const void *buf, size_t count) {
-    const uint8_t *p = buf;
-    size_t left = count;
-    while (left > 0) {
-        ssize_t n = write(fd, p, left);
-        if (n <= 0) {
-            if (errno == EINTR) continue;
-            return -1;
+// The reader thread answers PING, so every send takes the lock
+static int send_line(const char *msg) {
+    pthread_mutex_lock(&send_lock);
+    int rc = send_msg(sockfd, msg);
+    pthread_mutex_unlock(&send_lock);
+    return rc;
+}
+
+// Send an opcode frame with raw operands (binary mode)
+int send_op_data(int fd, uint8_t op, const void *data, size_t len) {
+    uint8_t payload[MAX_PAYLOAD], buf[4 + MAX_PAYLOAD];
+    if (len > MAX_PAYLOAD - 1) len = MAX_PAYLOAD - 1;
+    payload[0] = op;
+    if (len) memcpy(payload + 1, data, len);
+    size_t n = frame_put(buf, payload, (uint32_t)(1 + len));
+    pthread_mutex_lock(&send_lock);
+    ssize_t rc = write_all(fd, buf, n);
+    pthread_mutex_unlock(&send_lock);
+    return rc < 0 ? -1 : 0;
+}
+
+// An opcode frame with optional text (binary mode)
+int send_op(int fd, uint8_t op, const char *text) {
+    return send_op_data(fd, op, text, text ? strlen(text) : 0);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return ntohl(v);
+}
+
+// The link dropped: reconnect and send RESUME with the session from WELCOME,
+// retrying for as long as the server holds the seat. The server answers
+// with WELCOME, BANKROLL and RESYNC. Returns -1 when it is time to give up.
+static int resume_session(void) {
+    for (int tries = 0; client_running && tries < RESUME_GRACE_SEC; ++tries) {
+        if (tries) sleep(1);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            close(fd);
+            continue;
         }
-        left -= (size_t)n; p += n;
+        char buf[MAX_PAYLOAD];
+        snprintf(buf, sizeof(buf), "%s %s", binary_mode ? CMD_RESUME_BIN : CMD_RESUME, session);
+        pthread_mutex_lock(&send_lock);
+        close(sockfd);
+        sockfd = fd;
+        int rc = send_msg(sockfd, buf);
+        pthread_mutex_unlock(&send_lock);
+        if (rc == 0) return 0;
     }
-    return (ssize_t)count;
+    return -1;
 }
 
-ssize_t read_all(int fd, void *buf, size_t count) {
-    uint8_t *p = buf;
-    size_t left = count;
-    while (left > 0) {
-        ssize_t n = read(fd, p, left);
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            return -1;
+// RESYNC after RESUME: the round number, whose turn it is and your hands
+static void print_resync(const uint8_t *d, uint32_t n) {
+    if (n < 8) return;
+    printf("[RESYNC] round %u, turn %d, hand %d of %d:", get_u32(d + 1), d[5], d[6] + 1, d[7]);
+    uint32_t off = 8;
+    for (int k = 0; k < d[7] && off + 5 <= n; ++k) {
+        uint32_t ncards = d[off + 4];
+        printf(" [%u chips:", get_u32(d + off));
+        for (uint32_t i = 0; i < ncards && off + 5 + i < n; ++i) {
+            char c[4];
+            card_to_str(d[off + 5 + i], c);
+            printf(" %s", c);
         }
-        if (n == 0) return (ssize_t)(count - left);
-        left -= (size_t)n; p += n;
+        printf("]");
+        off += 5 + ncards;
     }
-    return (ssize_t)count;
+    printf("\n");
 }
 
-int send_msg(int fd, const char *msg) {
-    uint32_t len = (uint32_t)strlen(msg);
-    uint32_t nlen = htonl(len);
-    if (write_all(fd, &nlen, sizeof(nlen)) < 0) return -1;
-    if (write_all(fd, msg, len) < 0) return -1;
-    return 0;
+// A spectator's binary event, printed like the ASCII SEAT/DEALER lines
+static void print_seat_event(int id, const uint8_t *d, uint32_t n) {
+    static const char *outcomes[] = { "WIN", "LOSE", "PUSH" };
+    char c0[4], c1[4];
+    if (n >= 2) card_to_str(d[1], c0);
+    if (n >= 3) card_to_str(d[2], c1);
+    switch (d[0]) {
+    case OP_DEAL: if (n >= 3) printf("[TABLE] SEAT %d DEAL %s %s\n", id, c0, c1); break;
+    case OP_TURN: printf("[TABLE] SEAT %d TURN\n", id); break;
+    case OP_CARD: if (n >= 2) printf("[TABLE] SEAT %d CARD %s\n", id, c0); break;
+    case OP_BUSTED: printf("[TABLE] SEAT %d BUSTED\n", id); break;
+    case OP_RESULT:
+        if (n >= 12 && d[1] <= 2)
+            printf("[TABLE] SEAT %d RESULT %s %d %d %u %u\n", id, outcomes[d[1]], d[2], d[3], get_u32(d + 4), get_u32(d + 8));
+        break;
+    case OP_SPLIT_DEAL: if (n >= 3) printf("[TABLE] SEAT %d SPLIT %s %s\n", id, c0, c1); break;
+    case OP_DEALER_SHOW: if (n >= 3) printf("[TABLE] DEALER SHOWS %s %s\n", c0, c1); break;
+    case OP_DEALER_HIT: if (n >= 2) printf("[TABLE] DEALER HITS %s\n", c0); break;
+    default: printf("[TABLE] unknown opcode 0x%02x\n", d[0]); break;
+    }
 }
 
-int recv_msg(int fd, char **out_buf) {
-    uint32_t nlen;
-    ssize_t r = read_all(fd, &nlen, sizeof(nlen));
-    if (r <= 0) return -1;
-    uint32_t len = ntohl(nlen);
-    if (len > MAX_PAYLOAD) return -1;
-    char *buf = malloc(len+1);
-    if (!buf) return -1;
-    if (read_all(fd, buf, len) != (ssize_t)len) { free(buf); return -1; }
-    buf[len] = '\0';
-    *out_buf = buf;
-    return (int)len;
+// Print a binary frame the same way its ASCII counterpart is printed
+static void print_binary(const FrameView *msg) {
+    static const char *outcomes[] = { "WIN", "LOSE", "PUSH" };
+    const uint8_t *d = (const uint8_t *)msg->data;
+    uint32_t n = msg->len;
+    char c0[4], c1[4];
+    if (n == 0) return;
+    switch (d[0]) {
+    case OP_WELCOME:
+        if (n < 2 + SESSION_TOKEN_LEN) break;
+        for (int i = 0; i < SESSION_TOKEN_LEN; ++i) snprintf(session + 2 * i, 3, "%02x", d[2 + i]);
+        printf("[SERVER] WELCOME %.*s %d\n", (int)(n - 2 - SESSION_TOKEN_LEN), msg->data + 2 + SESSION_TOKEN_LEN, d[1]);
+        break;
+    case OP_RESYNC:
+        print_resync(d, n);
+        break;
+    case OP_TURN:
+        printf("[SERVER] It's your turn.\n");
+        printf("[SERVER] Type HIT, STAND, DOUBLE or SPLIT:\n");
+        my_turn = 1;
+        break;
+    case OP_DEAL:
+        if (n < 3) break;
+        card_to_str(d[1], c0);
+        card_to_str(d[2], c1);
+        printf("[DEAL] %s %s\n", c0, c1);
+        break;
+    case OP_CARD:
+        if (n < 2) break;
+        card_to_str(d[1], c0);
+        printf("[CARD] %s\n", c0);
+        break;
+    case OP_BUSTED:
+        printf("[SERVER] You BUSTED!\n");
+        my_turn = 0;
+        break;
+    case OP_RESULT:
+        if (n < 12 || d[1] > 2) break;
+        printf("[RESULT] %s %d %d %u %u\n", outcomes[d[1]], d[2], d[3], get_u32(d + 4), get_u32(d + 8));
+        my_turn = 0;
+        break;
+    case OP_BANKROLL:
+        if (n >= 9) printf("[BANKROLL] %u chips, betting %u\n", get_u32(d + 1), get_u32(d + 5));
+        break;
+    case OP_SPLIT_DEAL:
+        if (n < 3) break;
+        card_to_str(d[1], c0);
+        card_to_str(d[2], c1);
+        printf("[SPLIT] %s %s\n", c0, c1);
+        break;
+    case OP_DEALER_SHOW:
+        if (n < 3) break;
+        card_to_str(d[1], c0);
+        card_to_str(d[2], c1);
+        printf("[BROADCAST] Dealer shows %s %s\n", c0, c1);
+        break;
+    case OP_DEALER_HIT:
+        if (n < 2) break;
+        card_to_str(d[1], c0);
+        printf("[BROADCAST] Dealer hits %s\n", c0);
+        break;
+    case OP_BROADCAST:
+        printf("[BROADCAST] %.*s\n", (int)(n - 1), msg->data + 1);
+        break;
+    case OP_ERROR:
+        printf("[ERROR] %.*s\n", (int)(n - 1), msg->data + 1);
+        break;
+    case OP_WATCHING: {
+        if (n < 3) break;
+        uint16_t id;
+        memcpy(&id, d + 1, 2);
+        printf("[SERVER] WATCHING %d\n", ntohs(id));
+        break;
+    }
+    case OP_SEAT_EVENT:
+        if (n >= 3) print_seat_event(d[1], d + 2, n - 2);
+        break;
+    case OP_ADVICE: {
+        if (n < 11) break;
+        static const char *moves[] = { "STAND", "HIT", "DOUBLE", "SPLIT" };
+        printf("[ADVICE] %s %d", d[1] < 4 ? moves[d[1]] : "?", d[2]);
+        for (int i = 0; i < 4; ++i) {
+            uint16_t v;
+            memcpy(&v, d + 3 + 2 * i, 2);
+            int16_t milli = (int16_t)ntohs(v);
+            if (milli == ADVICE_NONE) printf(" -");
+            else printf(" %.3f", milli / 1000.0);
+        }
+        printf("\n");
+        break;
+    }
+    default:
+        printf("[SERVER] unknown opcode 0x%02x\n", d[0]);
+        break;
+    }
 }
 
 void *reader_func(void *arg) {
     (void)arg;
+    static FrameReader rd; // frames are parsed in place, nothing is allocated per message
+    frame_reader_init(&rd);
+    int resuming = 0; // RESUME sent, no WELCOME yet
     while (client_running) {
-        char *msg = NULL;
-        int rc = recv_msg(sockfd, &msg);
-        if (rc <= 0) {
+        FrameView msg;
+        int rc = frame_recv(sockfd, &rd, &msg);
+        if (rc < 0) {
+            // seated and not refused a resume already: try to get the seat back
+            if (client_running && session[0] && !resuming) {
+                printf("Connection lost, resuming...\n");
+                if (resume_session() == 0) {
+                    frame_reader_init(&rd);
+                    resuming = 1;
+                    continue;
+                }
+            }
             printf("Disconnected from server or read error\n");
             client_running = 0;
             break;
         }
+        if (binary_mode ? msg.len > 0 && (uint8_t)msg.data[0] == OP_WELCOME : frame_is(&msg, MSG_WELCOME))
+            resuming = 0;
+        if (binary_mode) {
+            if (msg.len > 0 && (uint8_t)msg.data[0] == OP_PING) send_op(sockfd, OP_PONG, NULL);
+            else print_binary(&msg);
+            continue;
+        }
         // print protocol tokens neatly
-        if (strncmp(msg, MSG_WELCOME, strlen(MSG_WELCOME)) == 0) {
-            printf("[SERVER] %s\n", msg);
-        } else if (strncmp(msg, MSG_DEAL, strlen(MSG_DEAL)) == 0) {
+        uint32_t alen;
+        const char *arg;
+        if (frame_is(&msg, MSG_PING)) {
+            send_line(CMD_PONG); // keepalive, nothing to show
+        } else if (frame_is(&msg, MSG_WELCOME)) {
+            // "<name> <player_id> <session>" follows; keep the session for RESUME
+            if (frame_recv(sockfd, &rd, &msg) < 0) continue;
+            uint32_t shown = msg.len;
+            while (shown > 0 && msg.data[shown - 1] != ' ') shown--;
+            if (shown > 0 && msg.len - shown == 2 * SESSION_TOKEN_LEN) {
+                memcpy(session, msg.data + shown, 2 * SESSION_TOKEN_LEN);
+                shown--;
+            } else {
+                shown = msg.len;
+            }
+            printf("[SERVER] WELCOME %.*s\n", (int)shown, msg.data);
+        } else if (frame_is(&msg, MSG_WATCHING)) {
+            printf("[SERVER] %.*s\n", (int)msg.len, msg.data);
+        } else if (frame_is(&msg, MSG_RESYNC)) {
+            // RESYNC <round> <turn> <hand> <hands> then <stake> <ncards> <cards...> per hand
+            arg = frame_arg(&msg, MSG_RESYNC, &alen);
+            printf("[RESYNC] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_SEAT) || frame_is(&msg, MSG_DEALER)) {
+            printf("[TABLE] %.*s\n", (int)msg.len, msg.data);
+        } else if (frame_is(&msg, MSG_DEAL)) {
             // DEAL <card1> <card2>
-            printf("[DEAL] %s\n", msg + strlen(MSG_DEAL) + 1);
-        } else if (strncmp(msg, MSG_YOUR_TURN, strlen(MSG_YOUR_TURN)) == 0) {
+            arg = frame_arg(&msg, MSG_DEAL, &alen);
+            printf("[DEAL] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_YOUR_TURN)) {
             printf("[SERVER] It's your turn.\n");
             my_turn = 1;
-        } else if (strncmp(msg, MSG_REQUEST_ACTION, strlen(MSG_REQUEST_ACTION)) == 0) {
-            printf("[SERVER] Type HIT or STAND:\n");
-        } else if (strncmp(msg, MSG_CARD, strlen(MSG_CARD)) == 0) {
-            printf("[CARD] %s\n", msg + strlen(MSG_CARD) + 1);
-        } else if (strncmp(msg, MSG_BUSTED, strlen(MSG_BUSTED)) == 0) {
+        } else if (frame_is(&msg, MSG_REQUEST_ACTION)) {
+            printf("[SERVER] Type HIT, STAND, DOUBLE or SPLIT:\n");
+        } else if (frame_is(&msg, MSG_CARD)) {
+            arg = frame_arg(&msg, MSG_CARD, &alen);
+            printf("[CARD] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_BUSTED)) {
             printf("[SERVER] You BUSTED!\n");
             my_turn = 0;
-        } else if (strncmp(msg, MSG_RESULT, strlen(MSG_RESULT)) == 0) {
-            printf("[RESULT] %s\n", msg + strlen(MSG_RESULT) + 1);
+        } else if (frame_is(&msg, MSG_RESULT)) {
+            arg = frame_arg(&msg, MSG_RESULT, &alen);
+            printf("[RESULT] %.*s\n", (int)alen, arg);
             my_turn = 0;
-        } else if (strncmp(msg, MSG_BROADCAST, strlen(MSG_BROADCAST)) == 0) {
-            // read next frame to get broadcast text (server sometimes sends separate frames)
-            printf("[BROADCAST] "); // rest of message may come in another frame
-            // if trailing text available in same frame, print
-            // In our server implementation, we send BROADCAST then separate text; so try to read next message
-            char *next = NULL;
-            if (recv_msg(sockfd, &next) > 0) {
-                printf("%s\n", next);
-                free(next);
+        } else if (frame_is(&msg, MSG_BANKROLL)) {
+            // BANKROLL <balance> <bet>
+            arg = frame_arg(&msg, MSG_BANKROLL, &alen);
+            printf("[BANKROLL] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_SPLIT)) {
+            arg = frame_arg(&msg, MSG_SPLIT, &alen);
+            printf("[SPLIT] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_ADVICE)) {
+            // ADVICE <move> <hand_value> <ev_stand> <ev_hit> <ev_double> <ev_split>
+            arg = frame_arg(&msg, MSG_ADVICE, &alen);
+            printf("[ADVICE] %.*s\n", (int)alen, arg);
+        } else if (frame_is(&msg, MSG_BROADCAST)) {
+            // the server sends BROADCAST and then the text as a separate frame
+            printf("[BROADCAST] ");
+            arg = frame_arg(&msg, MSG_BROADCAST, &alen);
+            if (alen > 0) {
+                printf("%.*s\n", (int)alen, arg);
+            } else if (frame_recv(sockfd, &rd, &msg) >= 0) {
+                printf("%.*s\n", (int)msg.len, msg.data);
             } else {
                 printf("\n");
             }
-        } else if (strncmp(msg, MSG_ERROR, strlen(MSG_ERROR)) == 0) {
-            printf("[ERROR] %s\n", msg + strlen(MSG_ERROR) + 1);
+        } else if (frame_is(&msg, MSG_ERROR)) {
+            // the reason usually follows in the next frame
+            arg = frame_arg(&msg, MSG_ERROR, &alen);
+            if (alen > 0) {
+                printf("[ERROR] %.*s\n", (int)alen, arg);
+            } else if (frame_recv(sockfd, &rd, &msg) >= 0) {
+                printf("[ERROR] %.*s\n", (int)msg.len, msg.data);
+            } else {
+                printf("[ERROR]\n");
+            }
         } else {
             // unknown token: print raw
-            printf("[SERVER] %s\n", msg);
+            printf("[SERVER] %.*s\n", (int)msg.len, msg.data);
         }
-        free(msg);
     }
     return NULL;
 }
 
 void usage(const char *pname) {
-    printf("Usage: %s <server_ip> <port> <player_name>\n", pname);
+    printf("Usage: %s <server_ip> <port> <player_name> [--binary]\n", pname);
+    printf("       %s <server_ip> <port> --watch <table_id> [--binary]\n", pname);
 }
 
 int main(int argc, char **argv) {
@@ -123,20 +335,27 @@ int main(int argc, char **argv) {
     const char *server_ip = argv[1];
     int port = atoi(argv[2]);
     const char *player_name = argv[3];
+    watch_mode = strcmp(argv[3], "--watch") == 0;
+    if (watch_mode && argc < 5) {
+        usage(argv[0]);
+        return 1;
+    }
+    int opts = watch_mode ? 5 : 4; // --binary goes after the name or table
+    binary_mode = argc > opts && strcmp(argv[opts], "--binary") == 0;
 
     sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) { perror("socket"); return 1; }
-    struct sockaddr_in srv;
-    memset(&srv, 0, sizeof(srv));
-    srv.sin_family = AF_INET;
-    srv.sin_port = htons(port);
-    if (inet_pton(AF_INET, server_ip, &srv.sin_addr) <= 0) { perror("inet_pton"); return 1; }
-    if (connect(sockfd, (struct sockaddr*)&srv, sizeof(srv)) < 0) { perror("connect"); return 1; }
-
-    // send JOIN
+    struct sockaddr_in *srv = &server_addr; // kept for RESUME
+    srv->sin_family = AF_INET;
+    srv->sin_port = htons(port);
+    if (inet_pton(AF_INET, server_ip, &srv->sin_addr) <= 0) { perror("inet_pton"); return 1; }
+    if (connect(sockfd, (struct sockaddr*)srv, sizeof(*srv)) < 0) { perror("connect"); return 1; }
+
+    // send JOIN, or WATCH for a spectator
     char joinbuf[MAX_PAYLOAD];
-    snprintf(joinbuf, sizeof(joinbuf), CMD_JOIN " %s", player_name);
-    if (send_msg(sockfd, joinbuf) < 0) { perror("send"); return 1; }
+    if (watch_mode) snprintf(joinbuf, sizeof(joinbuf), "%s %s", binary_mode ? CMD_WATCH_BIN : CMD_WATCH, argv[4]);
+    else snprintf(joinbuf, sizeof(joinbuf), "%s %s", binary_mode ? CMD_JOIN_BIN : CMD_JOIN, player_name);
+    if (send_line(joinbuf) < 0) { perror("send"); return 1; }
 
     // spawn reader thread
     pthread_create(&reader_thread, NULL, reader_func, NULL);
@@ -148,29 +367,61 @@ int main(int argc, char **argv) {
         // trim newline
         char *nl = strchr(line, '\n');
         if (nl) *nl = '\0';
-        // commands: HIT, STAND, QUIT, CHAT <message>
+        // commands: HIT, STAND, DOUBLE, SPLIT, HINT, BET [chips], QUIT, CHAT <message>; spectators can only QUIT
+        if (watch_mode && strcasecmp(line, "QUIT") != 0) {
+            printf("Watching only. Use QUIT to leave\n");
+            continue;
+        }
         if (strcasecmp(line, "HIT") == 0) {
             if (!my_turn) {
                 printf("Not your turn yet.\n");
                 continue;
             }
-            send_msg(sockfd, CMD_ACTION " HIT");
+            if (binary_mode) send_op(sockfd, OP_HIT, NULL);
+            else send_line(CMD_ACTION " HIT");
         } else if (strcasecmp(line, "STAND") == 0) {
             if (!my_turn) {
             printf("Not your turn yet.\n");
             continue;
             }
-            send_msg(sockfd, CMD_ACTION " STAND");
+            if (binary_mode) send_op(sockfd, OP_STAND, NULL);
+            else send_line(CMD_ACTION " STAND");
+        } else if (strcasecmp(line, "DOUBLE") == 0 || strcasecmp(line, "SPLIT") == 0) {
+            if (!my_turn) {
+                printf("Not your turn yet.\n");
+                continue;
+            }
+            int dbl = strcasecmp(line, "DOUBLE") == 0;
+            if (binary_mode) send_op(sockfd, dbl ? OP_DOUBLE : OP_SPLIT, NULL);
+            else send_line(dbl ? CMD_ACTION " DOUBLE" : CMD_ACTION " SPLIT");
+        } else if (strcasecmp(line, "BET") == 0 || strncasecmp(line, "BET ", 4) == 0) {
+            long chips = line[3] ? strtol(line + 4, NULL, 10) : 0;
+            if (binary_mode) {
+                uint32_t nchips = htonl((uint32_t)(chips > 0 ? chips : 0));
+                send_op_data(sockfd, OP_BET, &nchips, sizeof(nchips));
+                continue;
+            }
+            char buf[MAX_PAYLOAD];
+            snprintf(buf, sizeof(buf), CMD_BET " %ld", chips);
+            send_line(buf);
+        } else if (strcasecmp(line, "HINT") == 0) {
+            if (binary_mode) send_op(sockfd, OP_HINT, NULL);
+            else send_line(CMD_HINT);
         } else if (strcasecmp(line, "QUIT") == 0) {
-            send_msg(sockfd, CMD_QUIT);
+            if (binary_mode) send_op(sockfd, OP_QUIT, NULL);
+            else send_line(CMD_QUIT);
             client_running = 0;
             break;
         } else if (strncasecmp(line, "CHAT ", 5) == 0) {
+            if (binary_mode) {
+                send_op(sockfd, OP_CHAT, line + 5);
+                continue;
+            }
             char buf[MAX_PAYLOAD];
             snprintf(buf, sizeof(buf), CMD_CHAT " %s", line + 5);
-            send_msg(sockfd, buf);
+            send_line(buf);
         } else {
-            printf("Unknown command. Use HIT, STAND, QUIT, CHAT <message>\n");
+            printf("Unknown command. Use HIT, STAND, DOUBLE, SPLIT, HINT, BET [chips], QUIT, CHAT <message>\n");
         }
     }
 
@@ -25,8 +25,11 @@
 #define MAX_PLAYERS 6
 #define DEFAULT_PORT 12345
 #define ACTION_TIMEOUT_SEC 30  // seconds to wait for player's action
+#define KEEPALIVE_SEC 30       // silence before the server sends PING, and again before it gives up
+#define LOBBY_TIMEOUT_SEC 10   // seconds a new connection gets to send JOIN or WATCH
+#define RESUME_GRACE_SEC 30    // a dropped player's seat and hand are held this long for RESUME
 
-// helper prototypes:
+// blocking I/O helpers, in frame.c:
 ssize_t write_all(int fd, const void *buf, size_t count);
 ssize_t read_all(int fd, void *buf, size_t count);
 int send_msg(int fd, const char *msg);
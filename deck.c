@@ -0,0 +1,87 @@
+// deck.c
+#include "deck.h"
+
+void shoe_init(Shoe *s, int decks, int penetration_pct) {
+    if (decks < 1) decks = 1;
+    if (decks > MAX_DECKS) decks = MAX_DECKS;
+    if (penetration_pct < 1) penetration_pct = 1;
+    if (penetration_pct > 100) penetration_pct = 100;
+    s->size = 52 * decks;
+    for (int i = 0; i < s->size; ++i) s->cards[i] = (Card)(i % 52);
+    s->cut = s->size * penetration_pct / 100;
+    s->top = 0;
+}
+
+// Fisher-Yates over whatever order the shoe is in; every card is back in play.
+void shoe_shuffle(Shoe *s, Rng *rng) {
+    for (int i = s->size - 1; i > 0; --i) {
+        int j = (int)rng_bounded(rng, (uint32_t)i + 1);
+        Card tmp = s->cards[i]; s->cards[i] = s->cards[j]; s->cards[j] = tmp;
+    }
+    s->top = 0;
+}
+
+Card shoe_deal(Shoe *s) {
+    if (s->top >= s->size) {
+        // caller should swap in a fresh shoe before
+        return 0xFF;
+    }
+    return s->cards[s->top++];
+}
+
+int shoe_past_cut(const Shoe *s) {
+    return s->top >= s->cut;
+}
+
+// Card names are looked up rather than formatted: this runs for every
+// ASCII DEAL/CARD frame.
+void card_to_str(Card c, char *out) {
+    static const char suits[] = "SHDC"; // spade, heart, diamond, club
+    static const char ranks[13][3] = { "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K" };
+    if (c > 51) { memcpy(out, "??", 3); return; }
+    const char *r = ranks[c % 13]; // 0 = Ace, 9 = 10, 10=J,11=Q,12=K
+    out[0] = suits[c / 13];
+    out[1] = r[0];
+    out[2] = r[1];
+    out[3] = '\0';
+}
+
+int card_from_str(const char *s, size_t len, Card *out) {
+    static const char suits[] = "SHDC";
+    if (len < 2 || len > 3) return -1;
+    const char *suit = memchr(suits, s[0], 4);
+    if (!suit) return -1;
+    int rank;
+    switch (s[1]) {
+    case 'A': rank = 0; break;
+    case 'J': rank = 10; break;
+    case 'Q': rank = 11; break;
+    case 'K': rank = 12; break;
+    case '1': rank = (len == 3 && s[2] == '0') ? 9 : -1; break;
+    default: rank = (s[1] >= '2' && s[1] <= '9' && len == 2) ? s[1] - '1' : -1; break;
+    }
+    if (rank < 0 || (len == 3 && rank != 9)) return -1;
+    *out = (Card)((suit - suits) * 13 + rank);
+    return 0;
+}
+
+const uint8_t card_points[52] = {
+#define SUIT_POINTS 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 10, 10, 10
+    SUIT_POINTS, SUIT_POINTS, SUIT_POINTS, SUIT_POINTS
+#undef SUIT_POINTS
+};
+
+int hand_value(const Card *hand, int n) {
+    int total = 0, aces = 0;
+    for (int i = 0; i < n; ++i) {
+        int r = hand[i] % 13;
+        if (r == 0) { aces++; total += 11; }
+        else if (r >= 10) total += 10;
+        else total += (r + 1);
+    }
+    while (total > 21 && aces > 0) {
+        total -= 10;
+        aces--;
+    }
+    return total;
+}
@@ -3,13 +3,46 @@
 #define DECK_H
 
 #include "common.h"
+#include "rng.h"
 
 typedef uint8_t Card; // 0..51
 
-void init_deck(Card deck[52]);
-void shuffle_deck(Card deck[52], unsigned *seedp);
-Card deal_card(Card deck[52], int *top_index);
+#define MAX_DECKS 8
+
+// A dealing shoe of 1..MAX_DECKS decks. Cards come off the top; once the
+// top passes the cut card the shoe should be replaced before the next round.
+typedef struct {
+    Card cards[52 * MAX_DECKS];
+    int size;  // 52 * decks
+    int top;   // next card to deal
+    int cut;   // cut card position
+} Shoe;
+
+void shoe_init(Shoe *s, int decks, int penetration_pct); // ordered, cut at penetration_pct of the shoe
+void shoe_shuffle(Shoe *s, Rng *rng);
+Card shoe_deal(Shoe *s); // 0xFF once empty
+int shoe_past_cut(const Shoe *s);
 void card_to_str(Card c, char *out); // out must be large enough (e.g., 4 bytes)
-int hand_value(const Card *hand, int n);
+int card_from_str(const char *s, size_t len, Card *out); // inverse of card_to_str; -1 if malformed
+int hand_value(const Card *hand, int n); // reference evaluator
+
+// Incremental hand: aces count 1 in `hard`, and one of them is promoted to
+// 11 when that doesn't bust. O(1) per dealt card, no rank decode.
+typedef struct {
+    uint8_t hard;  // total with every ace as 1
+    uint8_t aces;
+} HandState;
+
+extern const uint8_t card_points[52]; // blackjack points, ace = 1
+
+static inline void hand_state_add(HandState *h, Card c) {
+    uint8_t pts = card_points[c];
+    h->hard += pts;
+    h->aces += pts == 1;
+}
+
+static inline int hand_state_value(HandState h) {
+    return h.hard + (h.aces && h.hard <= 11 ? 10 : 0);
+}
 
 #endif // DECK_H
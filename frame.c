@@ -0,0 +1,160 @@
+// frame.c
+#include "frame.h"
+
+void frame_reader_init(FrameReader *r) {
+    r->len = 0;
+    r->off = 0;
+    r->skip = 0;
+}
+
+ssize_t frame_fill(FrameReader *r, int fd) {
+    ssize_t n = read(fd, r->buf + r->len, sizeof(r->buf) - r->len);
+    if (n > 0) r->len += (size_t)n;
+    return n;
+}
+
+// Move the unparsed tail to the front so the next read has room
+static void compact(FrameReader *r) {
+    if (r->off == 0) return;
+    memmove(r->buf, r->buf + r->off, r->len - r->off);
+    r->len -= r->off;
+    r->off = 0;
+}
+
+FrameStatus frame_next(FrameReader *r, FrameView *v) {
+    if (r->skip > 0) {
+        size_t avail = r->len - r->off;
+        size_t n = avail < r->skip ? avail : r->skip;
+        r->off += n;
+        r->skip -= (uint32_t)n;
+        if (r->skip > 0) {
+            r->len = r->off = 0;
+            return FRAME_NEED_MORE;
+        }
+    }
+    size_t avail = r->len - r->off;
+    if (avail < 4) {
+        compact(r);
+        return FRAME_NEED_MORE;
+    }
+    uint32_t nlen;
+    memcpy(&nlen, r->buf + r->off, sizeof(nlen));
+    uint32_t len = ntohl(nlen);
+    if (len > MAX_PAYLOAD) {
+        // too big; drain it as it arrives and report it once
+        r->off += 4;
+        r->skip = len;
+        return FRAME_OVERSIZE;
+    }
+    if (avail - 4 < len) {
+        compact(r);
+        return FRAME_NEED_MORE;
+    }
+    v->data = (const char*)r->buf + r->off + 4;
+    v->len = len;
+    r->off += 4 + len;
+    return FRAME_OK;
+}
+
+int frame_recv(int fd, FrameReader *r, FrameView *v) {
+    for (;;) {
+        FrameStatus st = frame_next(r, v);
+        if (st == FRAME_OK) return (int)v->len;
+        if (st == FRAME_OVERSIZE) continue;
+        ssize_t n = frame_fill(r, fd);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+    }
+}
+
+int frame_is(const FrameView *v, const char *token) {
+    size_t n = strlen(token);
+    return v->len >= n && memcmp(v->data, token, n) == 0;
+}
+
+const char *frame_arg(const FrameView *v, const char *token, uint32_t *len) {
+    uint32_t i = (uint32_t)strlen(token);
+    if (i > v->len) i = v->len;
+    while (i < v->len && v->data[i] == ' ') i++;
+    *len = v->len - i;
+    return v->data + i;
+}
+
+size_t frame_put(uint8_t *out, const void *payload, uint32_t len) {
+    uint32_t nlen = htonl(len);
+    memcpy(out, &nlen, sizeof(nlen));
+    memcpy(out + 4, payload, len);
+    return 4 + (size_t)len;
+}
+
+// ------------------ blocking helpers ------------------
+
+ssize_t write_all(int fd, const void *buf, size_t count) {
+    const uint8_t *p = buf;
+    size_t left = count;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n <= 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        left -= (size_t)n;
+        p += n;
+    }
+    return (ssize_t)count;
+}
+
+ssize_t read_all(int fd, void *buf, size_t count) {
+    uint8_t *p = buf;
+    size_t left = count;
+    while (left > 0) {
+        ssize_t n = read(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return (ssize_t)(count - left); // EOF
+        left -= (size_t)n;
+        p += n;
+    }
+    return (ssize_t)count;
+}
+
+// Prefix and payload leave in one write
+int send_msg(int fd, const char *msg) {
+    uint8_t buf[4 + MAX_PAYLOAD];
+    size_t len = strlen(msg);
+    if (len > MAX_PAYLOAD) return -1;
+    return write_all(fd, buf, frame_put(buf, msg, (uint32_t)len)) < 0 ? -1 : 0;
+}
+
+int recv_msg(int fd, char **out_buf) {
+    uint32_t nlen;
+    ssize_t r = read_all(fd, &nlen, sizeof(nlen));
+    if (r <= 0) return -1;
+    uint32_t len = ntohl(nlen);
+    if (len == 0) {
+        *out_buf = strdup("");
+        return 0;
+    }
+    if (len > MAX_PAYLOAD) {
+        // too big; drain and return error
+        char tmp[256];
+        size_t to_read = len;
+        while (to_read > 0) {
+            ssize_t rr = read(fd, tmp, sizeof(tmp) < to_read ? sizeof(tmp) : to_read);
+            if (rr <= 0) break;
+            to_read -= rr;
+        }
+        return -1;
+    }
+    char *buf = malloc(len + 1);
+    if (!buf) return -1;
+    if (read_all(fd, buf, len) != (ssize_t)len) {
+        free(buf);
+        return -1;
+    }
+    buf[len] = '\0';
+    *out_buf = buf;
+    return (int)len;
+}
@@ -0,0 +1,39 @@
+// frame.h
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "common.h"
+
+// A received frame, pointing into the reader's buffer. Not NUL-terminated;
+// valid until the next frame_fill/frame_next/frame_recv on the same reader.
+typedef struct {
+    const char *data;
+    uint32_t len;
+} FrameView;
+
+// Per-connection receive buffer. Frames are parsed in place, so receiving
+// never allocates; oversized payloads are drained through the same buffer.
+typedef struct {
+    uint8_t buf[4 + MAX_PAYLOAD]; // room for one maximum-sized frame
+    size_t len;                   // bytes buffered
+    size_t off;                   // start of the next unparsed frame
+    uint32_t skip;                // bytes of an oversized payload left to discard
+} FrameReader;
+
+typedef enum {
+    FRAME_NEED_MORE = 0, // no complete frame buffered
+    FRAME_OK,            // *v holds the next frame
+    FRAME_OVERSIZE       // a frame over MAX_PAYLOAD was announced and is being discarded
+} FrameStatus;
+
+void frame_reader_init(FrameReader *r);
+ssize_t frame_fill(FrameReader *r, int fd); // one read(); 0 on EOF, -1 on error
+FrameStatus frame_next(FrameReader *r, FrameView *v);
+int frame_recv(int fd, FrameReader *r, FrameView *v); // blocking; payload length or -1
+size_t frame_put(uint8_t *out, const void *payload, uint32_t len); // length prefix + payload; returns 4 + len
+
+// Token helpers for views (prefix match, like the strncmp checks they replace)
+int frame_is(const FrameView *v, const char *token);
+const char *frame_arg(const FrameView *v, const char *token, uint32_t *len); // text after token and spaces
+
+#endif // FRAME_H
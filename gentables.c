@@ -0,0 +1,312 @@
+// gentables.c
+// Build-time generator for strategy_tables.c (see strategy.h). For every
+// shoe size and dealer upcard it plays out the exact probability tree over
+// the cards left in the shoe, memoizing on the multiset of cards drawn, and
+// scores hands with the server's own rules and payouts (deck.c, rules.c):
+// naturals pay 3:2, and the dealer, who doesn't peek, takes every other hand
+// with one.
+//
+// A hand's entry averages its exact stand, hit and double values over every
+// hand of that value and softness, two-card hands apart from longer ones,
+// weighted by the chance of being dealt exactly those cards. A pair's split
+// value plays each hand on from the pair card plus one more, doubling
+// allowed and no naturals, with the other hand's card out of the shoe but
+// the two hands otherwise valued independently.
+// Usage: ./gentables [strategy_tables.c], default stdout
+#include "common.h"
+#include "deck.h"
+#include "rules.h"
+#include "strategy.h"
+#include "table.h" // MAX_HAND
+
+#define MEMO_SIZE (1 << 15) // well above the few thousand hands either side can draw
+#define DEALER_NATURAL DEALER_TOTALS // score of the dealer's two-card 21, after the final totals
+#define SCORES (DEALER_TOTALS + 1)
+#define UNIT BLACKJACK_PAYS_DEN      // stake that a 3:2 natural pays in whole chips
+
+// A drawn multiset packed as a 4-bit count per point value; no hand holds
+// more than MAX_HAND cards
+#define KEY_SHIFT(v) (4 * ((v) - 1))
+#define KEY_COUNT(key, v) ((int)(((key) >> KEY_SHIFT(v)) & 0xF))
+
+static int left[11], left_total; // cards left in the shoe by points, ace = 1
+static int upcard;                // points, or UPCARD_HIDDEN
+static int split_hands;           // valuing the hands of a split: a two-card 21 isn't a natural
+
+typedef struct {
+    uint64_t key;
+    uint32_t gen;   // valid when it matches the table's current generation
+    double a, b, c; // dealer: expectation in a; player: stand, hit and double
+} Memo;
+
+static Memo dealer_memo[MEMO_SIZE], player_memo[MEMO_SIZE];
+static uint32_t dealer_gen, player_gen;
+
+static Card points_card(int v) {
+    return (Card)(v - 1); // spade of that rank; suits don't matter here
+}
+
+static Memo *memo_find(Memo *tab, uint32_t gen, uint64_t key) {
+    size_t i = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 49) & (MEMO_SIZE - 1);
+    while (tab[i].gen == gen && tab[i].key != key) i = (i + 1) & (MEMO_SIZE - 1);
+    return &tab[i];
+}
+
+// Units won, the way settle_round pays a hand
+static double payoff(Outcome o, int natural) {
+    return (double)(hand_return(o, natural, UNIT) - UNIT) / UNIT;
+}
+
+// Expected score[final value] of the dealer's hand `h`, `drawn` holding
+// the cards it took from the current `left`. One scalar per state rather
+// than a whole distribution: the player side only ever needs one payoff.
+static double dealer_expect(HandState h, int ncards, uint64_t drawn, const double score[SCORES]) {
+    if (!dealer_hits(h) || ncards == MAX_HAND) {
+        int v = hand_state_value(h);
+        if (ncards == 2 && v == 21) return score[DEALER_NATURAL];
+        return score[v > 21 ? 22 : v];
+    }
+    Memo *m = memo_find(dealer_memo, dealer_gen, drawn);
+    if (m->gen == dealer_gen) return m->a;
+
+    double e = 0;
+    for (int v = 1; v <= 10; ++v) {
+        if (!left[v]) continue;
+        double pr = (double)left[v] / left_total;
+        HandState n = h;
+        hand_state_add(&n, points_card(v));
+        left[v]--; left_total--;
+        e += pr * dealer_expect(n, ncards + 1, drawn + ((uint64_t)1 << KEY_SHIFT(v)), score);
+        left[v]++; left_total++;
+    }
+    m = memo_find(dealer_memo, dealer_gen, drawn); // the recursion may have filled our slot
+    m->key = drawn;
+    m->gen = dealer_gen;
+    m->a = e;
+    return e;
+}
+
+// Start a dealer tree from the upcard; every call is a fresh memo
+static double dealer_start(const double score[SCORES]) {
+    HandState d = { 0, 0 };
+    if (upcard != UPCARD_HIDDEN) hand_state_add(&d, points_card(upcard));
+    dealer_gen++;
+    return dealer_expect(d, upcard != UPCARD_HIDDEN, 0, score);
+}
+
+static double stand_value(HandState h, int natural) {
+    double score[SCORES];
+    int pv = hand_state_value(h);
+    for (int t = 0; t < DEALER_TOTALS; ++t) score[t] = payoff(natural_outcome(pv, natural, t, 0), natural);
+    score[DEALER_NATURAL] = payoff(natural_outcome(pv, natural, 21, 1), natural);
+    return dealer_start(score);
+}
+
+static double max3(double a, double b, double c) {
+    double m = a > b ? a : b;
+    return m > c ? m : c;
+}
+
+// Exact values of standing, of hitting (then playing on optimally) and of
+// doubling with the player's cards `drawn` already out of `left`
+static void player_value(HandState h, int ncards, uint64_t drawn, double *stand, double *hit, double *dbl) {
+    Memo *m = memo_find(player_memo, player_gen, drawn);
+    if (m->gen == player_gen) {
+        *stand = m->a;
+        *hit = m->b;
+        *dbl = m->c;
+        return;
+    }
+
+    double s = stand_value(h, !split_hands && ncards == 2 && hand_state_value(h) == 21), ht = 0, db = 0;
+    if (ncards == MAX_HAND) {
+        ht = s; // the table treats a hit on a full hand as a stand
+        db = 2 * s;
+    } else {
+        for (int v = 1; v <= 10; ++v) {
+            if (!left[v]) continue;
+            double pr = (double)left[v] / left_total;
+            HandState n = h;
+            hand_state_add(&n, points_card(v));
+            if (hand_state_value(n) > 21) { // a bust loses before the dealer plays
+                ht += pr * payoff(OUTCOME_LOSE, 0);
+                db += pr * 2 * payoff(OUTCOME_LOSE, 0);
+                continue;
+            }
+            double ns, nh, nd;
+            left[v]--; left_total--;
+            player_value(n, ncards + 1, drawn + ((uint64_t)1 << KEY_SHIFT(v)), &ns, &nh, &nd);
+            left[v]++; left_total++;
+            ht += pr * (ns > nh ? ns : nh);
+            db += pr * 2 * ns; // a doubled hand takes one card and stands
+        }
+    }
+    m = memo_find(player_memo, player_gen, drawn);
+    m->key = drawn;
+    m->gen = player_gen;
+    m->a = *stand = s;
+    m->b = *hit = ht;
+    m->c = *dbl = db;
+}
+
+// Both hands of a split pair of v, in units of the original stake. Split
+// aces take one card each and stand.
+static double split_value(int v) {
+    left[v] -= 2; left_total -= 2;
+    split_hands = 1;
+    player_gen++;
+    double e = 0;
+    for (int x = 1; x <= 10; ++x) {
+        if (!left[x]) continue;
+        double pr = (double)left[x] / left_total;
+        HandState n = { 0, 0 };
+        hand_state_add(&n, points_card(v));
+        hand_state_add(&n, points_card(x));
+        double s, ht, db;
+        left[x]--; left_total--;
+        player_value(n, 2, (uint64_t)1 << KEY_SHIFT(x), &s, &ht, &db);
+        left[x]++; left_total++;
+        e += pr * (v == 1 ? s : max3(s, ht, db));
+    }
+    split_hands = 0;
+    left[v] += 2; left_total += 2;
+    return 2 * e;
+}
+
+typedef struct {
+    double weight, stand, hit, dbl;
+} Accum;
+
+static Accum accum[2][2][STRATEGY_TOTALS]; // [opening][soft][value]
+static double pair_best[11];               // an opening pair's best move short of splitting
+
+// Every hand of two or more cards the player can hold, as a multiset drawn
+// in non-decreasing points; `weight` is the chance of being dealt exactly it
+static void walk(HandState h, int ncards, uint64_t drawn, int min_v, double weight) {
+    if (ncards >= 2) {
+        double s, ht, db;
+        player_value(h, ncards, drawn, &s, &ht, &db);
+        Accum *a = &accum[ncards == 2][h.aces && h.hard <= 11][hand_state_value(h)];
+        a->weight += weight;
+        a->stand += weight * s;
+        a->hit += weight * ht;
+        a->dbl += weight * db;
+        if (ncards == 2 && KEY_COUNT(drawn, min_v) == 2) pair_best[min_v] = max3(s, ht, db);
+    }
+    if (ncards == MAX_HAND) return;
+    for (int v = min_v; v <= 10; ++v) {
+        if (!left[v]) continue;
+        HandState n = h;
+        hand_state_add(&n, points_card(v));
+        if (hand_state_value(n) > 21) break; // larger cards bust too
+        // C(left, k) / C(total, n) grows by one card of v
+        double w = weight * left[v] / (KEY_COUNT(drawn, v) + 1) * (ncards + 1) / left_total;
+        left[v]--; left_total--;
+        walk(n, ncards + 1, drawn + ((uint64_t)1 << KEY_SHIFT(v)), v, w);
+        left[v]++; left_total++;
+    }
+}
+
+static void fill_shoe(int decks, int up) {
+    for (int v = 1; v <= 9; ++v) left[v] = 4 * decks;
+    left[10] = 16 * decks;
+    left_total = 52 * decks;
+    upcard = up;
+    if (up != UPCARD_HIDDEN) { left[up]--; left_total--; }
+}
+
+static void emit_tables(FILE *out) {
+    static StrategyEntry strat[MAX_DECKS][UPCARDS][2][2][STRATEGY_TOTALS];
+    static double dealer[MAX_DECKS][UPCARDS][DEALER_TOTALS];
+
+    for (int d = 1; d <= MAX_DECKS; ++d) {
+        for (int up = 0; up < UPCARDS; ++up) {
+            fill_shoe(d, up);
+            for (int t = 0; t < DEALER_TOTALS; ++t) {
+                double score[SCORES] = { 0 };
+                score[t] = 1.0;
+                if (t == 21) score[DEALER_NATURAL] = 1.0;
+                dealer[d - 1][up][t] = dealer_start(score);
+            }
+
+            memset(accum, 0, sizeof(accum));
+            player_gen++;
+            walk((HandState){ 0, 0 }, 0, 0, 1, 1.0);
+            for (int opening = 0; opening < 2; ++opening) {
+                for (int soft = 0; soft < 2; ++soft) {
+                    for (int v = 0; v < STRATEGY_TOTALS; ++v) {
+                        const Accum *a = &accum[opening][soft][v];
+                        StrategyEntry *e = &strat[d - 1][up][opening][soft][v];
+                        if (a->weight == 0) continue; // no such hand, e.g. hard 3
+                        e->stand = (float)(a->stand / a->weight);
+                        e->hit = (float)(a->hit / a->weight);
+                        e->hit_best = a->hit > a->stand;
+                        if (!opening) continue;
+                        e->dbl = (float)(a->dbl / a->weight);
+                        e->best = a->dbl > a->stand && a->dbl > a->hit ? MOVE_DOUBLE : e->hit_best ? MOVE_HIT : MOVE_STAND;
+                    }
+                }
+            }
+            // after the walk: each split starts a memo of its own
+            for (int v = 1; v <= 10; ++v) {
+                StrategyEntry *e = &strat[d - 1][up][1][v == 1][v == 1 ? 12 : 2 * v];
+                double split = split_value(v);
+                e->split = (float)split;
+                e->split_best = split > pair_best[v];
+            }
+        }
+        fprintf(stderr, "gentables: %d deck%s done\n", d, d > 1 ? "s" : "");
+    }
+
+    fprintf(out, "// strategy_tables.c: generated by gentables, do not edit\n");
+    fprintf(out, "#include \"strategy.h\"\n\n");
+    fprintf(out, "const StrategyEntry strategy_table[MAX_DECKS][UPCARDS][2][2][STRATEGY_TOTALS] = {\n");
+    for (int d = 0; d < MAX_DECKS; ++d) {
+        fprintf(out, "  { // %d deck%s\n", d + 1, d ? "s" : "");
+        for (int up = 0; up < UPCARDS; ++up) {
+            fprintf(out, "    { // upcard %d\n", up);
+            for (int opening = 0; opening < 2; ++opening) {
+                fprintf(out, "      { // %s\n", opening ? "two cards" : "three or more");
+                for (int soft = 0; soft < 2; ++soft) {
+                    fprintf(out, "        { ");
+                    for (int v = 0; v < STRATEGY_TOTALS; ++v) {
+                        const StrategyEntry *e = &strat[d][up][opening][soft][v];
+                        fprintf(out, "{%.6ff,%.6ff,%.6ff,%.6ff,%d,%d,%d},", e->stand, e->hit, e->dbl, e->split,
+                                e->hit_best, e->best, e->split_best);
+                    }
+                    fprintf(out, " },\n");
+                }
+                fprintf(out, "      },\n");
+            }
+            fprintf(out, "    },\n");
+        }
+        fprintf(out, "  },\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const float dealer_final_odds[MAX_DECKS][UPCARDS][DEALER_TOTALS] = {\n");
+    for (int d = 0; d < MAX_DECKS; ++d) {
+        fprintf(out, "  {\n");
+        for (int up = 0; up < UPCARDS; ++up) {
+            fprintf(out, "    { ");
+            for (int t = 0; t < DEALER_TOTALS; ++t) fprintf(out, "%.8ff,", dealer[d][up][t]);
+            fprintf(out, " },\n");
+        }
+        fprintf(out, "  },\n");
+    }
+    fprintf(out, "};\n");
+}
+
+int main(int argc, char **argv) {
+    FILE *out = stdout;
+    if (argc > 1 && !(out = fopen(argv[1], "w"))) {
+        perror(argv[1]);
+        return 1;
+    }
+    emit_tables(out);
+    if (fclose(out) != 0) {
+        perror("fclose");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// hand_bench.c
+// Hand evaluators: first proves HandState and the batch kernel agree with
+// the reference hand_value on every reachable hand, then times all three.
+#include "common.h"
+#include "deck.h"
+#include "handeval.h"
+#include "rng.h"
+
+#define MAX_CARDS 12          // same cap as a table's MAX_HAND
+#define VERIFY_BATCH 4096
+#define BENCH_HANDS (1 << 16)
+#define BENCH_REPS 200
+
+// ------------------ verification ------------------
+
+static Card batch_cards[MAX_CARDS][VERIFY_BATCH];
+static uint8_t batch_sizes[VERIFY_BATCH], batch_expect[VERIFY_BATCH];
+static int batch_len;
+static uint64_t checked, failures;
+
+static void flush_batch(void) {
+    uint8_t got[VERIFY_BATCH];
+    HandBatch b = { &batch_cards[0][0], batch_sizes, VERIFY_BATCH, MAX_CARDS };
+    hand_values_batch(&b, batch_len, got);
+    for (int i = 0; i < batch_len; ++i) {
+        if (got[i] != batch_expect[i] && failures++ < 10)
+            fprintf(stderr, "batch mismatch: %d cards, expected %d got %d\n", batch_sizes[i], batch_expect[i], got[i]);
+    }
+    batch_len = 0;
+}
+
+// Every hand a player or the dealer can hold: keep drawing while the value
+// is at most 21, any rank each time. Suits rotate so all 52 ids appear.
+static void walk(Card *hand, int n, HandState h) {
+    int ref = hand_value(hand, n);
+    checked++;
+    if (hand_state_value(h) != ref && failures++ < 10)
+        fprintf(stderr, "HandState mismatch: %d cards, expected %d got %d\n", n, ref, hand_state_value(h));
+
+    for (int k = 0; k < n; ++k) batch_cards[k][batch_len] = hand[k];
+    for (int k = n; k < MAX_CARDS; ++k) batch_cards[k][batch_len] = 0xEE; // must be ignored
+    batch_sizes[batch_len] = (uint8_t)n;
+    batch_expect[batch_len] = (uint8_t)ref;
+    if (++batch_len == VERIFY_BATCH) flush_batch();
+
+    if (ref > 21 || n == MAX_CARDS) return;
+    for (int rank = 0; rank < 13; ++rank) {
+        Card c = (Card)(rank + 13 * ((n + rank) % 4));
+        HandState next = h;
+        hand_state_add(&next, c);
+        hand[n] = c;
+        walk(hand, n + 1, next);
+    }
+}
+
+static int verify(void) {
+    Card hand[MAX_CARDS];
+    walk(hand, 0, (HandState){ 0, 0 });
+    flush_batch();
+    printf("verified %" PRIu64 " hands: %s\n", checked, failures ? "MISMATCH" : "all evaluators agree");
+    return failures ? -1 : 0;
+}
+
+// ------------------ timing ------------------
+
+static Card hands[BENCH_HANDS][MAX_CARDS];          // array of structs, for the scalar paths
+static Card soa[MAX_CARDS][BENCH_HANDS];            // the same hands, structure of arrays
+static uint8_t sizes[BENCH_HANDS], out[BENCH_HANDS];
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    if (verify() < 0) return 1;
+
+    Rng rng;
+    rng_seed(&rng, RNG_XOSHIRO, 1);
+    int max_cards = 0;
+    for (int i = 0; i < BENCH_HANDS; ++i) {
+        sizes[i] = (uint8_t)(2 + rng_bounded(&rng, 4)); // 2..5 cards, typical final hands
+        if (sizes[i] > max_cards) max_cards = sizes[i];
+        for (int k = 0; k < sizes[i]; ++k) soa[k][i] = hands[i][k] = (Card)rng_bounded(&rng, 52);
+    }
+
+    uint64_t sink = 0;
+    double t0 = now_sec();
+    for (int r = 0; r < BENCH_REPS; ++r)
+        for (int i = 0; i < BENCH_HANDS; ++i) sink += (uint64_t)hand_value(hands[i], sizes[i]);
+    double ref_ns = (now_sec() - t0) * 1e9 / ((double)BENCH_REPS * BENCH_HANDS);
+
+    // incremental: what a dealer loop pays per card while the hand grows
+    t0 = now_sec();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        for (int i = 0; i < BENCH_HANDS; ++i) {
+            HandState h = { 0, 0 };
+            for (int k = 0; k < sizes[i]; ++k) hand_state_add(&h, hands[i][k]);
+            sink += (uint64_t)hand_state_value(h);
+        }
+    }
+    double inc_ns = (now_sec() - t0) * 1e9 / ((double)BENCH_REPS * BENCH_HANDS);
+
+    HandBatch b = { &soa[0][0], sizes, BENCH_HANDS, max_cards };
+    t0 = now_sec();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        hand_values_batch(&b, BENCH_HANDS, out);
+        sink += out[r];
+    }
+    double batch_ns = (now_sec() - t0) * 1e9 / ((double)BENCH_REPS * BENCH_HANDS);
+
+    printf("hand_value  %6.2f ns/hand\n", ref_ns);
+    printf("HandState   %6.2f ns/hand (built card by card)\n", inc_ns);
+    printf("batch SoA   %6.2f ns/hand (%d lanes)\n", batch_ns, HANDEVAL_LANES);
+    printf("(checksum %" PRIu64 ")\n", sink % 1000);
+    return 0;
+}
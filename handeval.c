@@ -0,0 +1,48 @@
+// handeval.c
+// Batched hand scoring with GCC vector extensions: the compiler emits
+// SSE2/AVX2/NEON as the target allows. Byte lanes are enough, since even
+// twelve tens only reach 120.
+#include "handeval.h"
+
+typedef uint8_t u8v __attribute__((vector_size(HANDEVAL_LANES)));
+
+static inline u8v load(const uint8_t *p) {
+    u8v v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Lane-wise hand values for HANDEVAL_LANES hands starting at column `base`
+static inline u8v score_lanes(const HandBatch *b, int base) {
+    u8v sizes = load(b->sizes + base);
+    u8v hard = { 0 }, aces = { 0 };
+    const Card *col = b->cards + base;
+    for (int k = 0; k < b->max_cards; ++k, col += b->stride) {
+        u8v c = load(col);
+        u8v live = (u8v)(sizes > (uint8_t)k);
+        // rank = c % 13 without a divide: subtract 13 once per suit boundary passed
+        u8v rank = c - (13 & (u8v)(c >= 13)) - (13 & (u8v)(c >= 26)) - (13 & (u8v)(c >= 39));
+        u8v pts = rank + 1;
+        u8v face = (u8v)(pts > 10);
+        pts = (pts & ~face) | (10 & face);
+        hard += pts & live;
+        aces += 1 & (u8v)(rank == 0) & live;
+    }
+    // one ace counts 11 when that doesn't bust
+    u8v soft = (u8v)(aces != 0) & (u8v)(hard <= 11);
+    return hard + (10 & soft);
+}
+
+void hand_values_batch(const HandBatch *b, int n, uint8_t *out) {
+    int i = 0;
+    for (; i + HANDEVAL_LANES <= n; i += HANDEVAL_LANES) {
+        u8v v = score_lanes(b, i);
+        memcpy(out + i, &v, sizeof(v));
+    }
+    // ragged tail: scalar, same rules
+    for (; i < n; ++i) {
+        HandState h = { 0, 0 };
+        for (int k = 0; k < b->sizes[i]; ++k) hand_state_add(&h, b->cards[(size_t)k * (size_t)b->stride + i]);
+        out[i] = (uint8_t)hand_state_value(h);
+    }
+}
@@ -0,0 +1,22 @@
+// handeval.h
+#ifndef HANDEVAL_H
+#define HANDEVAL_H
+
+#include "deck.h"
+
+#define HANDEVAL_LANES 16 // hands scored per vector step: one SSE2/NEON register
+
+// Structure-of-arrays batch: card k of hand i is cards[k * stride + i] and
+// hand i holds sizes[i] cards. Slots past a hand's size are ignored, so
+// they may hold anything.
+typedef struct {
+    const Card *cards;
+    const uint8_t *sizes;
+    int stride;      // >= n
+    int max_cards;   // card slots present (the largest size)
+} HandBatch;
+
+// out[i] = hand_value of hand i, HANDEVAL_LANES hands per step
+void hand_values_batch(const HandBatch *b, int n, uint8_t *out);
+
+#endif // HANDEVAL_H
@@ -0,0 +1,48 @@
+// hist.c
+#include "hist.h"
+
+// Largest value that lands in bucket b
+static uint64_t bucket_max(int b) {
+    if (b < HIST_SUB) return (uint64_t)b;
+    int msb = b / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b % HIST_SUB);
+    uint64_t lo = (1ull << msb) | (sub << (msb - HIST_SUB_BITS));
+    return lo + (1ull << (msb - HIST_SUB_BITS)) - 1;
+}
+
+void hist_reset(Hist *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+void hist_record(Hist *h, uint64_t v) {
+    h->counts[hist_bucket(v)]++;
+    h->total++;
+    h->sum += v;
+    if (v > h->max) h->max = v;
+}
+
+void hist_merge(Hist *into, const Hist *from) {
+    for (int i = 0; i < HIST_BUCKETS; ++i) into->counts[i] += from->counts[i];
+    into->total += from->total;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+}
+
+uint64_t hist_percentile(const Hist *h, double pct) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)h->total);
+    if (rank >= h->total) rank = h->total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h->counts[i];
+        if (seen > rank) {
+            uint64_t v = bucket_max(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+uint64_t hist_mean(const Hist *h) {
+    return h->total ? h->sum / h->total : 0;
+}
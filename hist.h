@@ -0,0 +1,35 @@
+// hist.h
+#ifndef HIST_H
+#define HIST_H
+
+#include "common.h"
+
+// Log-linear latency histogram: exact below 16, then 16 sub-buckets per
+// power of two (worst-case error ~6%). Fixed size, recording never
+// allocates. Units are whatever the caller records (we use microseconds).
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+    uint64_t sum;
+} Hist;
+
+// Bucket holding v; exposed for recorders that keep their own counts
+static inline int hist_bucket(uint64_t v) {
+    if (v < HIST_SUB) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int sub = (int)(v >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+void hist_reset(Hist *h);
+void hist_record(Hist *h, uint64_t v);
+void hist_merge(Hist *into, const Hist *from);
+uint64_t hist_percentile(const Hist *h, double pct); // upper bound of the bucket holding pct
+uint64_t hist_mean(const Hist *h);
+
+#endif // HIST_H
@@ -0,0 +1,55 @@
+// jdump.c
+// Prints a server journal (-j) as text, one record per line, or with -s a
+// summary of what it holds. Reads the file through mmap; the server may
+// still be appending to it.
+#include "common.h"
+#include "journal.h"
+
+#define NUM_TYPES (JR_RESULT + 1)
+
+static void summarize(const JournalRecord *recs, size_t n) {
+    uint64_t by_type[NUM_TYPES] = { 0 }, outcomes[3] = { 0 };
+    for (size_t i = 0; i < n; ++i) {
+        const JournalRecord *r = &recs[i];
+        if (r->type < NUM_TYPES) by_type[r->type]++;
+        if (r->type == JR_RESULT && r->data[0] < 3) outcomes[r->data[0]]++;
+    }
+    printf("%zu records\n", n);
+    for (int k = 1; k < NUM_TYPES; ++k) printf("%-10s %" PRIu64 "\n", journal_type_name(k), by_type[k]);
+    printf("results: %" PRIu64 " won, %" PRIu64 " lost, %" PRIu64 " pushed\n", outcomes[0], outcomes[1], outcomes[2]);
+    if (n > 0) printf("span %.3f s\n", (double)(recs[n - 1].at_us - recs[0].at_us) / 1e6);
+}
+
+static void usage(const char *pname) {
+    printf("Usage: %s [-s] [-t table] journal\n", pname);
+}
+
+int main(int argc, char **argv) {
+    int summary = 0, only_table = -1;
+    int opt;
+    while ((opt = getopt(argc, argv, "st:h")) != -1) {
+        switch (opt) {
+        case 's': summary = 1; break;
+        case 't': only_table = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) { usage(argv[0]); return 1; }
+
+    size_t n, map_len;
+    void *map;
+    const JournalRecord *recs = journal_map(argv[optind], &n, &map, &map_len);
+    if (!recs) { perror(argv[optind]); return 1; }
+    if (summary) {
+        summarize(recs, n);
+    } else {
+        char line[128];
+        for (size_t i = 0; i < n; ++i) {
+            if (only_table >= 0 && recs[i].table != only_table) continue;
+            journal_format(&recs[i], line, sizeof(line));
+            printf("%s\n", line);
+        }
+    }
+    journal_unmap(map, map_len);
+    return 0;
+}
@@ -0,0 +1,228 @@
+// journal.c
+#include "journal.h"
+#include "deck.h"
+#include "rng.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BATCH_RECORDS 4096 // records per write()
+
+static void header_init(JournalHeader *h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, JOURNAL_MAGIC, sizeof(h->magic));
+    h->version = JOURNAL_VERSION;
+    h->record_size = sizeof(JournalRecord);
+    h->byte_order = 0x01020304;
+}
+
+static int header_ok(const JournalHeader *h) {
+    JournalHeader want;
+    header_init(&want);
+    return memcmp(h->magic, want.magic, sizeof(h->magic)) == 0 && h->version == want.version &&
+           h->record_size == want.record_size && h->byte_order == want.byte_order;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int journal_open(Journal *j, const char *path, int nrings) {
+    memset(j, 0, sizeof(*j));
+    j->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (j->fd < 0) return -1;
+    struct stat st;
+    if (fstat(j->fd, &st) < 0) goto fail;
+    JournalHeader h;
+    if (st.st_size == 0) {
+        header_init(&h);
+        if (write_full(j->fd, &h, sizeof(h)) < 0) goto fail;
+    } else {
+        if (pread(j->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || !header_ok(&h)) {
+            errno = EINVAL;
+            goto fail;
+        }
+        // a crash can leave half a record at the end; drop it before appending
+        off_t body = st.st_size - (off_t)sizeof(h);
+        off_t whole = body - body % (off_t)sizeof(JournalRecord);
+        if (whole != body && ftruncate(j->fd, (off_t)sizeof(h) + whole) < 0) goto fail;
+    }
+    j->rings = calloc((size_t)nrings, sizeof(*j->rings));
+    if (!j->rings) goto fail;
+    j->nrings = nrings;
+    for (int i = 0; i < nrings; ++i) {
+        atomic_init(&j->rings[i].tail, 0);
+        atomic_init(&j->rings[i].head, 0);
+        j->rings[i].slots = malloc(JOURNAL_RING_SLOTS * sizeof(JournalRecord));
+        if (!j->rings[i].slots) goto fail;
+    }
+    atomic_init(&j->running, 0);
+    return 0;
+fail:
+    if (j->rings) {
+        for (int i = 0; i < nrings; ++i) free(j->rings[i].slots);
+        free(j->rings);
+        j->rings = NULL;
+    }
+    close(j->fd);
+    j->fd = -1;
+    return -1;
+}
+
+JournalRing *journal_ring(Journal *j, int i) {
+    return &j->rings[i];
+}
+
+// Move whatever the rings hold to the file; returns the records written
+static size_t drain(Journal *j, JournalRecord *batch) {
+    size_t total = 0, n = 0;
+    for (int i = 0; i < j->nrings; ++i) {
+        JournalRing *r = &j->rings[i];
+        unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+        unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        while (head != tail) {
+            batch[n++] = r->slots[head & (JOURNAL_RING_SLOTS - 1)];
+            head++;
+            if (n == BATCH_RECORDS) {
+                if (write_full(j->fd, batch, n * sizeof(*batch)) < 0) perror("journal write");
+                total += n;
+                n = 0;
+            }
+        }
+        // the slots are copied out; the producer may reuse them
+        atomic_store_explicit(&r->head, head, memory_order_release);
+    }
+    if (n > 0 && write_full(j->fd, batch, n * sizeof(*batch)) < 0) perror("journal write");
+    return total + n;
+}
+
+static void *logger_thread(void *arg) {
+    Journal *j = arg;
+    JournalRecord *batch = malloc(BATCH_RECORDS * sizeof(*batch));
+    if (!batch) {
+        perror("malloc");
+        return NULL;
+    }
+    while (atomic_load_explicit(&j->running, memory_order_acquire)) {
+        if (drain(j, batch) == 0) {
+            struct timespec ts = { 0, JOURNAL_IDLE_MS * 1000000L };
+            nanosleep(&ts, NULL);
+        }
+    }
+    drain(j, batch); // whatever the producers left before stopping
+    free(batch);
+    return NULL;
+}
+
+int journal_start(Journal *j) {
+    atomic_store(&j->running, 1);
+    if (pthread_create(&j->thread, NULL, logger_thread, j) != 0) {
+        atomic_store(&j->running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void journal_close(Journal *j) {
+    if (j->fd < 0) return;
+    if (atomic_exchange(&j->running, 0)) pthread_join(j->thread, NULL);
+    if (fsync(j->fd) < 0) perror("journal fsync");
+    close(j->fd);
+    j->fd = -1;
+    for (int i = 0; i < j->nrings; ++i) free(j->rings[i].slots);
+    free(j->rings);
+    j->rings = NULL;
+}
+
+const JournalRecord *journal_map(const char *path, size_t *nrecords, void **map, size_t *map_len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(JournalHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (p == MAP_FAILED) return NULL;
+    if (!header_ok(p)) {
+        munmap(p, (size_t)st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+    *map = p;
+    *map_len = (size_t)st.st_size;
+    *nrecords = ((size_t)st.st_size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    return (const JournalRecord *)((const uint8_t *)p + sizeof(JournalHeader));
+}
+
+void journal_unmap(void *map, size_t map_len) {
+    munmap(map, map_len);
+}
+
+static const char *type_names[] = {
+    "?", "START", "SHOE", "ROUND", "DEAL", "HOLE", "ACTION", "CARD", "BUST", "LEAVE", "DEALER_HIT", "RESULT"
+};
+static const char *action_names[] = { "NONE", "HIT", "STAND", "HINT", "DOUBLE", "SPLIT" };
+static const char *outcome_names[] = { "WIN", "LOSE", "PUSH" };
+#define NAME(names, i) ((i) < sizeof(names) / sizeof(names[0]) ? names[i] : "?")
+
+const char *journal_type_name(int type) {
+    return type >= 0 ? NAME(type_names, (unsigned)type) : "?";
+}
+
+void journal_format(const JournalRecord *r, char *buf, size_t size) {
+    char c0[4], c1[4];
+    card_to_str((Card)r->data[0], c0);
+    card_to_str((Card)r->data[1], c1);
+    int n = snprintf(buf, size, "%" PRIu64 " t%u r%u top=%u %s", r->at_us, r->table, r->round, r->shoe_top,
+                     journal_type_name(r->type));
+    if (n < 0 || (size_t)n >= size) return;
+    buf += n;
+    size -= (size_t)n;
+    if (r->seat != JOURNAL_TABLE_WIDE) {
+        n = snprintf(buf, size, " seat=%u", r->seat);
+        if (n < 0 || (size_t)n >= size) return;
+        buf += n;
+        size -= (size_t)n;
+    }
+    switch (r->type) {
+    case JR_START: {
+        uint16_t ntables;
+        memcpy(&ntables, &r->data[3], sizeof(ntables));
+        snprintf(buf, size, " decks=%u cut=%u%% rng=%s tables=%u seed=%" PRIu64 "%s", r->data[0], r->data[1],
+                 rng_kind_name((RngKind)r->data[2]), ntables, r->read_us,
+                 r->data[5] & JOURNAL_PARALLEL ? " parallel" : "");
+        break;
+    }
+    case JR_ROUND: snprintf(buf, size, " seats=0x%02x", r->data[0]); break;
+    case JR_DEAL: {
+        uint32_t stake;
+        memcpy(&stake, &r->data[2], sizeof(stake));
+        snprintf(buf, size, " %s %s stake=%" PRIu32, c0, c1, stake);
+        break;
+    }
+    case JR_HOLE: snprintf(buf, size, " %s %s", c0, c1); break;
+    case JR_CARD:
+    case JR_DEALER_HIT: snprintf(buf, size, " %s", c0); break;
+    case JR_ACTION:
+        if (r->data[1]) snprintf(buf, size, " %s (timeout)", NAME(action_names, r->data[0]));
+        else snprintf(buf, size, " %s queued=%" PRIu64 "us", NAME(action_names, r->data[0]), r->at_us - r->read_us);
+        break;
+    case JR_RESULT:
+        snprintf(buf, size, " hand=%u %s %u vs %u paid=%" PRIu64, r->data[3], NAME(outcome_names, r->data[0]),
+                 r->data[1], r->data[2], r->read_us);
+        break;
+    default: break;
+    }
+}
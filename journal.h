@@ -0,0 +1,94 @@
+// journal.h
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+// Append-only binary journal of every round. The file is a JournalHeader
+// followed by fixed-size JournalRecords in host byte order, so a reader can
+// mmap it and index records directly. Tables append to their worker's
+// lock-free ring and never touch the file; a logger thread drains the rings
+// and writes. A full ring drops the record rather than stall the table.
+
+#define JOURNAL_MAGIC "BJJRNL01"
+#define JOURNAL_VERSION 2
+#define JOURNAL_RING_SLOTS 8192   // per producer, power of two
+#define JOURNAL_IDLE_MS 10        // logger sleep when every ring was empty
+#define JOURNAL_TABLE_WIDE 0xFF   // `seat` of dealer and table events
+#define JOURNAL_PARALLEL 0x01     // JR_START flag: seats play their turns in parallel
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;  // sizeof(JournalRecord)
+    uint32_t byte_order;   // 0x01020304 as the writer stored it
+    uint32_t reserved;
+    uint64_t reserved2;
+} JournalHeader;
+
+typedef enum {
+    JR_START = 1,  // server started; data: decks, cut %, RngKind, u16 tables, JOURNAL_* flags; read_us: seed
+    JR_SHOE,       // a freshly shuffled shoe went into play
+    JR_ROUND,      // round dealt; data[0]: bitmask of seats in the round (who covered their bet)
+    JR_DEAL,       // seat's first two cards; data[0..1], data[2..5]: u32 stake
+    JR_HOLE,       // dealer's two cards; data[0..1]
+    JR_ACTION,     // data[0]: PlayerAction, data[1]: 1 if a timeout; read_us: frame read
+    JR_CARD,       // card drawn by a HIT; data[0]
+    JR_BUST,
+    JR_LEAVE,      // seat left mid-round and forfeits
+    JR_DEALER_HIT, // data[0]
+    JR_RESULT,     // data[0]: Outcome, data[1]: player total, data[2]: dealer total, data[3]: hand; read_us: chips paid
+} JournalType;
+
+typedef struct {
+    uint64_t at_us;     // monotonic_us() when the table did it
+    uint64_t read_us;   // see JournalType
+    uint32_t round;     // per-table round number, from 1
+    uint16_t table;     // table id, 0 for server events
+    uint16_t shoe_top;  // cards dealt from the current shoe after this record
+    uint8_t type;       // JournalType
+    uint8_t seat;
+    uint8_t data[6];
+} JournalRecord;
+
+_Static_assert(sizeof(JournalRecord) == 32, "journal records are fixed-size on disk");
+
+// Single-producer/single-consumer ring, one per producing thread
+typedef struct {
+    _Alignas(64) atomic_uint tail;   // written by the producer
+    _Alignas(64) atomic_uint head;   // written by the logger
+    JournalRecord *slots;
+} JournalRing;
+
+typedef struct {
+    int fd;
+    JournalRing *rings;
+    int nrings;
+    pthread_t thread;
+    atomic_int running;
+} Journal;
+
+// Opens (or continues) the journal at `path` with one ring per producer
+int journal_open(Journal *j, const char *path, int nrings);
+int journal_start(Journal *j);   // spawns the logger thread
+void journal_close(Journal *j);  // producers must be done; drains everything first
+JournalRing *journal_ring(Journal *j, int i);
+
+// Producer side: never blocks, -1 when the ring is full and the record dropped
+static inline int journal_put(JournalRing *r, const JournalRecord *rec) {
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (tail - head == JOURNAL_RING_SLOTS) return -1;
+    r->slots[tail & (JOURNAL_RING_SLOTS - 1)] = *rec;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+// Reader side: maps a journal read-only; records follow the header
+const JournalRecord *journal_map(const char *path, size_t *nrecords, void **map, size_t *map_len);
+void journal_unmap(void *map, size_t map_len);
+const char *journal_type_name(int type);
+void journal_format(const JournalRecord *r, char *buf, size_t size); // one line, no newline
+
+#endif // JOURNAL_H
@@ -0,0 +1,204 @@
+// ledger.c
+#include "ledger.h"
+#include "timer.h"
+#include <libgen.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+typedef struct {
+    char magic[8];
+    uint32_t record_size;  // sizeof(LedgerRecord)
+    uint32_t byte_order;   // 0x01020304 as the writer stored it
+    uint8_t reserved[48];
+} LedgerHeader;
+
+_Static_assert(sizeof(LedgerHeader) == sizeof(LedgerRecord), "the header keeps records aligned");
+
+static void header_init(LedgerHeader *h) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, LEDGER_MAGIC, sizeof(h->magic));
+    h->record_size = sizeof(LedgerRecord);
+    h->byte_order = 0x01020304;
+}
+
+static int write_full(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Append records and make them durable. Once a write or sync has failed the
+// log may end in changes that were never applied, so nothing more is taken.
+static int log_append(Ledger *l, const LedgerRecord *recs, int n) {
+    if (l->fd < 0 || n == 0) return 0;
+    if (atomic_load_explicit(&l->failed, memory_order_relaxed)) return -1;
+    if (write_full(l->fd, recs, (size_t)n * sizeof(*recs)) == 0 && fdatasync(l->fd) == 0) return 0;
+    if (!atomic_exchange(&l->failed, 1)) perror("ledger write");
+    return -1;
+}
+
+// A new log's directory entry has to be durable as well as its header
+static int sync_dir(const char *path) {
+    char buf[PATH_MAX];
+    snprintf(buf, sizeof(buf), "%s", path);
+    int fd = open(dirname(buf), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return -1;
+    int rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+static uint32_t name_hash(const char *name) {
+    uint32_t h = 2166136261u; // FNV-1a
+    for (; *name; ++name) h = (h ^ (uint8_t)*name) * 16777619u;
+    return h;
+}
+
+// Caller holds the bucket's stripe
+static Account *bucket_find(Ledger *l, uint32_t b, const char *name) {
+    for (Account *a = l->buckets[b]; a; a = a->next)
+        if (strcmp(a->name, name) == 0) return a;
+    return NULL;
+}
+
+static Account *bucket_add(Ledger *l, uint32_t b, const char *name, int64_t balance) {
+    Account *a = calloc(1, sizeof(*a));
+    if (!a) return NULL;
+    snprintf(a->name, sizeof(a->name), "%s", name);
+    a->stripe = (int)(b % LEDGER_STRIPES);
+    atomic_init(&a->balance, balance);
+    a->next = l->buckets[b];
+    l->buckets[b] = a;
+    return a;
+}
+
+// Single-threaded, before any table runs
+static int replay_log(Ledger *l) {
+    LedgerRecord recs[256];
+    off_t off = sizeof(LedgerHeader);
+    for (;;) {
+        ssize_t n = pread(l->fd, recs, sizeof(recs), off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        size_t count = (size_t)n / sizeof(LedgerRecord); // a torn last record is ignored
+        if (count == 0) return 0;
+        for (size_t i = 0; i < count; ++i) {
+            LedgerRecord *r = &recs[i];
+            r->name[MAX_NAME_LEN - 1] = '\0';
+            uint32_t b = name_hash(r->name) & (LEDGER_BUCKETS - 1);
+            Account *a = bucket_find(l, b, r->name);
+            if (a && r->type == LR_OPEN) continue; // never count a name's starting chips twice
+            if (!a && !(a = bucket_add(l, b, r->name, r->type == LR_OPEN ? 0 : l->starting))) return -1;
+            atomic_fetch_add_explicit(&a->balance, r->delta, memory_order_relaxed);
+        }
+        off += (off_t)(count * sizeof(LedgerRecord));
+    }
+}
+
+int ledger_open(Ledger *l, const char *path, int64_t starting) {
+    memset(l->buckets, 0, sizeof(l->buckets));
+    for (int i = 0; i < LEDGER_STRIPES; ++i) pthread_mutex_init(&l->stripes[i], NULL);
+    l->starting = starting;
+    l->fd = -1;
+    atomic_init(&l->failed, 0);
+    if (!path) return 0;
+    l->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (l->fd < 0) return -1;
+    struct stat st;
+    LedgerHeader h, want;
+    header_init(&want);
+    if (fstat(l->fd, &st) < 0) goto fail;
+    if (st.st_size == 0) {
+        if (write_full(l->fd, &want, sizeof(want)) < 0 || fdatasync(l->fd) < 0 || sync_dir(path) < 0) goto fail;
+        return 0;
+    }
+    if (pread(l->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || memcmp(&h, &want, sizeof(h)) != 0) {
+        errno = EINVAL;
+        goto fail;
+    }
+    if (replay_log(l) < 0) goto fail;
+    // a crash can leave half a record at the end; drop it before appending
+    off_t body = st.st_size - (off_t)sizeof(h);
+    off_t whole = body - body % (off_t)sizeof(LedgerRecord);
+    if (whole != body && (ftruncate(l->fd, (off_t)sizeof(h) + whole) < 0 || fdatasync(l->fd) < 0)) goto fail;
+    return 0;
+fail:
+    close(l->fd);
+    l->fd = -1;
+    return -1;
+}
+
+void ledger_close(Ledger *l) {
+    if (l->fd >= 0) close(l->fd);
+    l->fd = -1;
+}
+
+Account *ledger_account(Ledger *l, const char *name) {
+    uint32_t b = name_hash(name) & (LEDGER_BUCKETS - 1);
+    pthread_mutex_t *stripe = &l->stripes[b % LEDGER_STRIPES];
+    pthread_mutex_lock(stripe);
+    Account *a = bucket_find(l, b, name);
+    if (a) {
+        pthread_mutex_unlock(stripe);
+        return a;
+    }
+    // LR_OPEN is durable before the account exists, and so before any bet on it
+    LedgerRecord rec = { .at_us = monotonic_us(), .delta = l->starting, .balance = l->starting,
+                         .type = LR_OPEN, .seat = 0xFF };
+    snprintf(rec.name, sizeof(rec.name), "%s", name);
+    a = log_append(l, &rec, 1) == 0 ? bucket_add(l, b, name, l->starting) : NULL;
+    pthread_mutex_unlock(stripe);
+    return a;
+}
+
+int64_t ledger_balance(const Account *a) {
+    return atomic_load_explicit(&a->balance, memory_order_relaxed);
+}
+
+int ledger_commit(Ledger *l, LedgerChange *changes, int n) {
+    if (n > LEDGER_MAX_CHANGES) return -1;
+    // lock every stripe involved in index order, so two commits can't deadlock
+    uint64_t held = 0;
+    for (int i = 0; i < n; ++i) held |= 1ull << changes[i].account->stripe;
+    for (uint64_t h = held; h; h &= h - 1) pthread_mutex_lock(&l->stripes[__builtin_ctzll(h)]);
+
+    // work out every balance first; an account may come up more than once
+    LedgerRecord recs[LEDGER_MAX_CHANGES];
+    int logged = 0;
+    uint64_t now = monotonic_us();
+    for (int i = 0; i < n; ++i) {
+        LedgerChange *c = &changes[i];
+        int64_t cur = ledger_balance(c->account);
+        for (int j = i - 1; j >= 0; --j) {
+            if (changes[j].account != c->account || changes[j].refused) continue;
+            cur = changes[j].rec.balance;
+            break;
+        }
+        c->refused = cur + c->rec.delta < 0;
+        if (c->refused) continue;
+        c->rec.at_us = now;
+        c->rec.balance = cur + c->rec.delta;
+        memcpy(c->rec.name, c->account->name, sizeof(c->rec.name));
+        recs[logged++] = c->rec;
+    }
+
+    // durable first, then applied
+    int rc = log_append(l, recs, logged);
+    for (int i = 0; i < n; ++i) {
+        LedgerChange *c = &changes[i];
+        if (rc < 0) c->refused = 1;
+        else if (!c->refused) atomic_store_explicit(&c->account->balance, c->rec.balance, memory_order_relaxed);
+    }
+    for (uint64_t h = held; h; h &= h - 1) pthread_mutex_unlock(&l->stripes[__builtin_ctzll(h)]);
+    return rc;
+}
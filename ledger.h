@@ -0,0 +1,81 @@
+// ledger.h
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+// Player bankrolls, keyed by name and shared by every table. With a log this
+// is a write-ahead log: a table commits each step's changes as one group,
+// appended and fdatasync'd before any balance moves, and only then queues the
+// frames that report them. A change the log can't take is not made. After a
+// crash ledger_open() rebuilds every balance from the log, so a change is
+// either durable and applied or never happened. An account's balance only
+// changes under its stripe of the lock that also guards finding and opening
+// accounts; tables on different stripes commit in parallel, and reading a
+// balance takes no lock.
+
+#define LEDGER_MAGIC "BJLEDG01"
+#define LEDGER_BUCKETS 4096  // power of two
+#define LEDGER_STRIPES 64    // bucket i is guarded by stripes[i % LEDGER_STRIPES]
+#define LEDGER_MAX_CHANGES 16 // per commit
+
+_Static_assert(LEDGER_STRIPES <= 64, "a commit keeps the stripes it holds in a u64 mask");
+
+typedef struct Account {
+    struct Account *next;    // bucket chain; accounts are never freed
+    char name[MAX_NAME_LEN];
+    int stripe;              // the lock its balance changes under
+    _Atomic int64_t balance; // chips
+} Account;
+
+typedef enum {
+    LR_OPEN = 1,  // a name played for the first time; delta: starting chips
+    LR_BET,       // stake taken at the deal or by DOUBLE/SPLIT; delta < 0
+    LR_PAYOUT,    // chips paid back at settlement, stake included
+    LR_REFUND,    // stake handed back: too few seats covered their bets to deal
+} LedgerType;
+
+typedef struct {
+    uint64_t at_us;      // monotonic_us() when it was committed
+    int64_t delta;
+    int64_t balance;     // right after this change
+    uint32_t round;      // the table's round number, 0 for LR_OPEN
+    uint16_t table;
+    uint8_t type;        // LedgerType
+    uint8_t seat;
+    char name[MAX_NAME_LEN];
+} LedgerRecord;
+
+_Static_assert(sizeof(LedgerRecord) == 64, "ledger records are fixed-size on disk");
+
+// One change in a commit. The caller fills in the account and the record's
+// delta, type, round, table and seat; ledger_commit() the rest.
+typedef struct {
+    Account *account;
+    LedgerRecord rec;
+    int refused;         // a debit the balance couldn't cover: not logged, not applied
+} LedgerChange;
+
+typedef struct {
+    Account *buckets[LEDGER_BUCKETS];
+    pthread_mutex_t stripes[LEDGER_STRIPES];
+    int64_t starting;    // chips for a new name
+    int fd;              // write-ahead log, -1 when not logging
+    atomic_int failed;   // a write or sync failed: the log may hold changes never applied, so take no more
+} Ledger;
+
+// path NULL keeps the ledger in memory. Otherwise every record in the log is
+// replayed (balances are the sum of deltas, so records from different tables
+// may land in any order) and new ones are appended.
+int ledger_open(Ledger *l, const char *path, int64_t starting);
+void ledger_close(Ledger *l);
+Account *ledger_account(Ledger *l, const char *name); // find or open; NULL when out of memory or the log fails
+int64_t ledger_balance(const Account *a);
+// Apply n changes as one group: debits the balance can't cover are refused,
+// the rest are appended and synced in one write, then applied in order.
+// Returns -1, with every change refused and nothing applied, when the log
+// can't take them.
+int ledger_commit(Ledger *l, LedgerChange *changes, int n);
+
+#endif // LEDGER_H
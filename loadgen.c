@@ -0,0 +1,475 @@
+// loadgen.c
+// Headless load generator: thousands of bot players from one process, all
+// driven by a single epoll loop. Reports rounds/sec and latency percentiles
+// so the server's saturation point can be found without a client per player.
+#include "common.h"
+#include "protocol.h"
+#include "deck.h"
+#include "frame.h"
+#include "hist.h"
+#include "rng.h"
+#include "rules.h"
+#include "strategy.h"
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#define DEFAULT_CONNS 1000
+#define DEFAULT_SECONDS 30
+#define DEFAULT_RAMP 2000   // new connections per second
+#define MAX_EVENTS 256
+#define BOT_HAND 12
+
+typedef enum {
+    STRAT_STAND = 0,  // always stand
+    STRAT_DEALER,     // hit below 17, like the dealer
+    STRAT_RANDOM,     // coin flip below 21
+    STRAT_BASIC       // precomputed basic strategy, one table lookup
+} Strategy;
+
+typedef struct {
+    int fd;             // -1 once closed
+    int id;
+    int connected;      // handshake done and JOIN sent
+    int skip_text;      // ASCII: the next frame is the text of BROADCAST/ERROR
+    int welcome_text;   // ASCII: the next frame is the text of WELCOME
+    int rejoin;         // QUIT sent: reconnect under the next name once closed
+    int gen;            // rejoins so far, part of the name
+    int table;          // table id from the session token
+    int64_t bet;
+    FrameReader rd;
+    Card hand[BOT_HAND];
+    int hand_size;
+    uint64_t deal_us;   // when this round's DEAL arrived
+    uint64_t turn_us;   // first REQUEST_ACTION of this turn
+    uint64_t hit_us;    // HIT sent, waiting for its CARD
+} Bot;
+
+static Strategy strategy = STRAT_DEALER;
+static int binary_mode = 0;
+static int shoe_decks = 1; // the server's -d, for the basic strategy table
+static Rng rng;
+
+// totals, plus the current reporting interval
+static uint64_t rounds, interval_rounds, hits, errors, disconnects, rejoins;
+static int live;
+static Hist hit_rtt, turn_to_result, round_time, interval_hit;
+
+// per table id: when its current round was counted. All of a round's deals
+// come before its first RESULT, and the next round's after it.
+static uint64_t table_round_us[1 << 16];
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return ntohl(v);
+}
+
+// The space-separated numbers of an ASCII argument; returns how many
+static int parse_numbers(const char *arg, uint32_t len, int64_t *out, int max) {
+    int n = 0, in_num = 0;
+    for (uint32_t i = 0; i < len; ++i) {
+        if (arg[i] >= '0' && arg[i] <= '9') {
+            if (!in_num && n == max) break;
+            if (!in_num) out[n++] = 0;
+            out[n - 1] = out[n - 1] * 10 + (arg[i] - '0');
+            in_num = 1;
+        } else {
+            in_num = 0;
+        }
+    }
+    return n;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void bot_close(Bot *b) {
+    if (b->fd < 0) return;
+    close(b->fd); // also drops it from the epoll set
+    b->fd = -1;
+    if (b->connected) live--;
+    b->connected = 0;
+    if (!b->rejoin) disconnects++;
+}
+
+// Bots only ever send a few dozen bytes in reply to the server, so the
+// socket buffer never fills; a short write means the connection is broken.
+static void bot_send(Bot *b, const void *payload, size_t len) {
+    uint8_t buf[4 + 64];
+    if (b->fd < 0 || len > sizeof(buf) - 4) return;
+    uint32_t nlen = htonl((uint32_t)len);
+    memcpy(buf, &nlen, 4);
+    memcpy(buf + 4, payload, len);
+    if (write(b->fd, buf, 4 + len) != (ssize_t)(4 + len)) bot_close(b);
+}
+
+static int wants_hit(Bot *b) {
+    int v = hand_value(b->hand, b->hand_size);
+    switch (strategy) {
+    case STRAT_STAND: return 0;
+    case STRAT_DEALER: return v < 17;
+    case STRAT_RANDOM: return v < 21 && rng_bounded(&rng, 2);
+    case STRAT_BASIC: {
+        HandState h = { 0, 0 };
+        for (int i = 0; i < b->hand_size; ++i) hand_state_add(&h, b->hand[i]);
+        return v <= 21 && strategy_lookup(shoe_decks, UPCARD_HIDDEN, h, b->hand_size)->hit_best;
+    }
+    }
+    return 0;
+}
+
+// ------------------ game events (same for both protocols) ------------------
+
+static void on_deal(Bot *b, Card c0, Card c1) {
+    b->hand[0] = c0;
+    b->hand[1] = c1;
+    b->hand_size = 2;
+    b->deal_us = now_us();
+    b->turn_us = 0;
+    b->hit_us = 0;
+}
+
+static void on_request(Bot *b) {
+    uint64_t now = now_us();
+    if (!b->turn_us) b->turn_us = now;
+    if (wants_hit(b) && b->hand_size < BOT_HAND) {
+        b->hit_us = now;
+        hits++;
+        if (binary_mode) bot_send(b, (uint8_t[]){ OP_HIT }, 1);
+        else bot_send(b, CMD_ACTION " HIT", strlen(CMD_ACTION " HIT"));
+    } else {
+        if (binary_mode) bot_send(b, (uint8_t[]){ OP_STAND }, 1);
+        else bot_send(b, CMD_ACTION " STAND", strlen(CMD_ACTION " STAND"));
+    }
+}
+
+static void on_card(Bot *b, Card c) {
+    if (b->hand_size < BOT_HAND) b->hand[b->hand_size++] = c;
+    if (b->hit_us) {
+        uint64_t rtt = now_us() - b->hit_us;
+        hist_record(&hit_rtt, rtt);
+        hist_record(&interval_hit, rtt);
+        b->hit_us = 0;
+    }
+}
+
+static void on_welcome(Bot *b, int table) {
+    b->table = table;
+    b->bet = MIN_BET;
+}
+
+// Keep the bet covered so the seat is never sat out: drop it to what is
+// left (bets come in steps of BLACKJACK_PAYS_DEN), and below the table
+// minimum QUIT and rejoin with a fresh bankroll.
+static void on_balance(Bot *b, int64_t balance) {
+    if (balance >= b->bet) return;
+    balance -= balance % BLACKJACK_PAYS_DEN;
+    if (balance >= MIN_BET) {
+        b->bet = balance;
+        if (binary_mode) {
+            uint8_t op[5] = { OP_BET };
+            uint32_t chips = htonl((uint32_t)balance);
+            memcpy(op + 1, &chips, 4);
+            bot_send(b, op, sizeof(op));
+        } else {
+            char bet[32];
+            int n = snprintf(bet, sizeof(bet), CMD_BET " %" PRId64, balance);
+            bot_send(b, bet, (size_t)n);
+        }
+        return;
+    }
+    if (binary_mode) bot_send(b, (uint8_t[]){ OP_QUIT }, 1);
+    else bot_send(b, CMD_QUIT, strlen(CMD_QUIT));
+    b->rejoin = 1;
+}
+
+static void on_result(Bot *b, int64_t balance) {
+    uint64_t now = now_us();
+    // once per table round, by the first bot there to settle; a split's
+    // second RESULT finds deal_us already cleared
+    if (b->deal_us) {
+        if (b->deal_us > table_round_us[b->table]) {
+            table_round_us[b->table] = now;
+            rounds++;
+            interval_rounds++;
+        }
+        hist_record(&round_time, now - b->deal_us);
+    }
+    if (b->turn_us) hist_record(&turn_to_result, now - b->turn_us);
+    b->deal_us = b->turn_us = b->hit_us = 0;
+    on_balance(b, balance);
+}
+
+// ------------------ protocol decoding ------------------
+
+static void handle_ascii(Bot *b, const FrameView *msg) {
+    uint32_t alen;
+    const char *arg;
+    int64_t num[4];
+    Card c0, c1;
+    if (b->skip_text) {
+        b->skip_text = 0;
+        return;
+    }
+    if (b->welcome_text) {
+        // <name> <id> <session>: the session token opens with the u16 table id
+        b->welcome_text = 0;
+        uint32_t at = msg->len;
+        while (at > 0 && msg->data[at - 1] != ' ') at--;
+        char tid[5] = { 0 };
+        if (msg->len - at >= 4) memcpy(tid, msg->data + at, 4);
+        on_welcome(b, (int)strtol(tid, NULL, 16));
+        return;
+    }
+    if (frame_is(msg, MSG_WELCOME)) {
+        frame_arg(msg, MSG_WELCOME, &alen);
+        b->welcome_text = alen == 0;
+    } else if (frame_is(msg, MSG_BANKROLL)) {
+        arg = frame_arg(msg, MSG_BANKROLL, &alen);
+        if (parse_numbers(arg, alen, num, 2) == 2) on_balance(b, num[0]);
+    } else if (frame_is(msg, MSG_DEAL)) {
+        // DEAL <card1> <card2>
+        arg = frame_arg(msg, MSG_DEAL, &alen);
+        const char *sp = memchr(arg, ' ', alen);
+        if (sp && card_from_str(arg, (size_t)(sp - arg), &c0) == 0 &&
+            card_from_str(sp + 1, alen - (uint32_t)(sp - arg) - 1, &c1) == 0)
+            on_deal(b, c0, c1);
+    } else if (frame_is(msg, MSG_REQUEST_ACTION)) {
+        on_request(b);
+    } else if (frame_is(msg, MSG_PING)) {
+        bot_send(b, CMD_PONG, strlen(CMD_PONG));
+    } else if (frame_is(msg, MSG_CARD)) {
+        arg = frame_arg(msg, MSG_CARD, &alen);
+        if (card_from_str(arg, alen, &c0) == 0) on_card(b, c0);
+    } else if (frame_is(msg, MSG_RESULT)) {
+        // RESULT <outcome> <player_total> <dealer_total> <paid> <balance>
+        arg = frame_arg(msg, MSG_RESULT, &alen);
+        if (parse_numbers(arg, alen, num, 4) == 4) on_result(b, num[3]);
+    } else if (frame_is(msg, MSG_BROADCAST)) {
+        frame_arg(msg, MSG_BROADCAST, &alen);
+        b->skip_text = alen == 0;
+    } else if (frame_is(msg, MSG_ERROR)) {
+        errors++;
+        frame_arg(msg, MSG_ERROR, &alen);
+        b->skip_text = alen == 0;
+    }
+    // YOUR_TURN and BUSTED need no reply
+}
+
+static void handle_binary(Bot *b, const FrameView *msg) {
+    const uint8_t *d = (const uint8_t *)msg->data;
+    if (msg->len == 0) return;
+    switch (d[0]) {
+    case OP_WELCOME:
+        if (msg->len >= 4) on_welcome(b, d[2] << 8 | d[3]);
+        break;
+    case OP_BANKROLL:
+        if (msg->len >= 9) on_balance(b, get_u32(d + 1));
+        break;
+    case OP_DEAL:
+        if (msg->len >= 3) on_deal(b, d[1], d[2]);
+        break;
+    case OP_TURN:
+        on_request(b);
+        break;
+    case OP_CARD:
+        if (msg->len >= 2) on_card(b, d[1]);
+        break;
+    case OP_RESULT:
+        if (msg->len >= 12) on_result(b, get_u32(d + 8));
+        break;
+    case OP_ERROR:
+        errors++;
+        break;
+    case OP_PING:
+        bot_send(b, (uint8_t[]){ OP_PONG }, 1);
+        break;
+    }
+}
+
+// ------------------ connections ------------------
+
+static int bot_connect(Bot *b, const struct sockaddr_in *srv, int epfd) {
+    b->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (b->fd < 0) return -1;
+    b->skip_text = b->welcome_text = b->rejoin = 0;
+    b->deal_us = b->turn_us = b->hit_us = 0;
+    fcntl(b->fd, F_SETFL, fcntl(b->fd, F_GETFL, 0) | O_NONBLOCK);
+    frame_reader_init(&b->rd);
+    if (connect(b->fd, (const struct sockaddr *)srv, sizeof(*srv)) < 0 && errno != EINPROGRESS) {
+        bot_close(b);
+        return -1;
+    }
+    // EPOLLOUT reports the end of the handshake
+    struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = b };
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, b->fd, &ev) < 0) {
+        bot_close(b);
+        return -1;
+    }
+    return 0;
+}
+
+static void bot_connected(Bot *b, int epfd) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(b->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        bot_close(b);
+        return;
+    }
+    b->connected = 1;
+    live++;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = b };
+    epoll_ctl(epfd, EPOLL_CTL_MOD, b->fd, &ev);
+    char join[64];
+    int n = snprintf(join, sizeof(join), "%s bot%d", binary_mode ? CMD_JOIN_BIN : CMD_JOIN, b->id);
+    if (b->gen) n += snprintf(join + n, sizeof(join) - (size_t)n, ".%d", b->gen);
+    bot_send(b, join, (size_t)n);
+}
+
+static void bot_readable(Bot *b) {
+    for (;;) {
+        ssize_t n = frame_fill(&b->rd, b->fd);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+            bot_close(b);
+            return;
+        }
+        FrameView msg;
+        FrameStatus st;
+        while ((st = frame_next(&b->rd, &msg)) != FRAME_NEED_MORE) {
+            if (st != FRAME_OK) continue;
+            if (b->rejoin) continue; // QUIT sent, waiting for the close
+            if (binary_mode) handle_binary(b, &msg);
+            else handle_ascii(b, &msg);
+            if (b->fd < 0) return;
+        }
+        if (n < 0) return; // drained
+    }
+}
+
+// ------------------ main ------------------
+
+static void usage(const char *pname) {
+    printf("Usage: %s [-n conns] [-d seconds] [-r connects_per_sec] [-s stand|dealer|random|basic] [-D decks] [-b] [host] [port]\n", pname);
+}
+
+static void print_hist(const char *name, const Hist *h) {
+    printf("  %-16s n=%-9" PRIu64 " mean %7" PRIu64 "us  p50 %7" PRIu64 "us  p99 %7" PRIu64
+           "us  p99.9 %7" PRIu64 "us  max %7" PRIu64 "us\n",
+           name, h->total, hist_mean(h), hist_percentile(h, 50), hist_percentile(h, 99),
+           hist_percentile(h, 99.9), h->max);
+}
+
+int main(int argc, char **argv) {
+    int nconns = DEFAULT_CONNS, seconds = DEFAULT_SECONDS, ramp = DEFAULT_RAMP;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:r:s:D:bh")) != -1) {
+        switch (opt) {
+        case 'n': nconns = atoi(optarg); break;
+        case 'd': seconds = atoi(optarg); break;
+        case 'r': ramp = atoi(optarg); break;
+        case 's':
+            if (strcmp(optarg, "stand") == 0) strategy = STRAT_STAND;
+            else if (strcmp(optarg, "dealer") == 0) strategy = STRAT_DEALER;
+            else if (strcmp(optarg, "random") == 0) strategy = STRAT_RANDOM;
+            else if (strcmp(optarg, "basic") == 0) strategy = STRAT_BASIC;
+            else { usage(argv[0]); return 1; }
+            break;
+        case 'D': shoe_decks = atoi(optarg); break;
+        case 'b': binary_mode = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    const char *host = optind < argc ? argv[optind] : "127.0.0.1";
+    int port = optind + 1 < argc ? atoi(argv[optind + 1]) : DEFAULT_PORT;
+    if (nconns < 1) nconns = 1;
+    if (ramp < 1) ramp = 1;
+    if (shoe_decks < 1 || shoe_decks > MAX_DECKS) shoe_decks = 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    // one fd per bot: lift the soft limit as far as we are allowed
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct sockaddr_in srv;
+    memset(&srv, 0, sizeof(srv));
+    srv.sin_family = AF_INET;
+    srv.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &srv.sin_addr) <= 0) { perror("inet_pton"); return 1; }
+
+    Bot *bots = calloc((size_t)nconns, sizeof(*bots));
+    if (!bots) { perror("calloc"); return 1; }
+    for (int i = 0; i < nconns; ++i) {
+        bots[i].fd = -1;
+        bots[i].id = i + 1;
+    }
+    rng_seed(&rng, RNG_XOSHIRO, rng_entropy());
+    int epfd = epoll_create1(0);
+    if (epfd < 0) { perror("epoll_create1"); return 1; }
+
+    static const char *strategy_names[] = { "stand", "dealer", "random", "basic" };
+    printf("%d bots -> %s:%d, %s strategy, %s protocol, %ds\n", nconns, host, port,
+           strategy_names[strategy], binary_mode ? "binary" : "ascii", seconds);
+
+    uint64_t start = now_us(), next_report = start + 1000000, end = start + (uint64_t)seconds * 1000000;
+    int started = 0;
+    struct epoll_event events[MAX_EVENTS];
+    for (;;) {
+        uint64_t now = now_us();
+        if (now >= end) break;
+
+        // ramp: open however many connections the rate allows by now
+        int due = (int)((now - start) * (uint64_t)ramp / 1000000) + 1;
+        while (started < nconns && started < due) bot_connect(&bots[started++], &srv, epfd);
+
+        if (now >= next_report) {
+            printf("%4" PRIu64 "s  bots %6d  rounds/s %7" PRIu64 "  hit rtt p50 %6" PRIu64 "us p99 %6" PRIu64
+                   "us  errors %" PRIu64 "  closed %" PRIu64 "  rejoined %" PRIu64 "\n",
+                   (now - start) / 1000000, live, interval_rounds, hist_percentile(&interval_hit, 50),
+                   hist_percentile(&interval_hit, 99), errors, disconnects, rejoins);
+            fflush(stdout);
+            interval_rounds = 0;
+            hist_reset(&interval_hit);
+            next_report += 1000000;
+        }
+
+        int n = epoll_wait(epfd, events, MAX_EVENTS, 10);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Bot *b = events[i].data.ptr;
+            if (b->fd < 0) continue;
+            if (!b->connected) bot_connected(b, epfd);
+            else bot_readable(b);
+            if (b->rejoin && b->fd < 0) {
+                // broke: the server closed after QUIT, come back as somebody new
+                b->gen++;
+                rejoins++;
+                bot_connect(b, &srv, epfd);
+            }
+        }
+    }
+
+    double secs = (double)(now_us() - start) / 1e6;
+    printf("\n%" PRIu64 " rounds in %.1fs: %.1f rounds/s, %" PRIu64 " hits, %" PRIu64 " errors, %" PRIu64
+           " closed, %" PRIu64 " rejoined\n",
+           rounds, secs, (double)rounds / secs, hits, errors, disconnects, rejoins);
+    print_hist("hit -> card", &hit_rtt);
+    print_hist("turn -> result", &turn_to_result);
+    print_hist("deal -> result", &round_time);
+
+    for (int i = 0; i < nconns; ++i) {
+        if (bots[i].fd >= 0) close(bots[i].fd);
+    }
+    free(bots);
+    close(epfd);
+    return 0;
+}
@@ -0,0 +1,29 @@
+// mailbox.c
+#include "mailbox.h"
+
+void mailbox_init(Mailbox *m) {
+    atomic_init(&m->tail, 0);
+    atomic_init(&m->head, 0);
+}
+
+int mailbox_push(Mailbox *m, int action, uint64_t at_us) {
+    unsigned tail = atomic_load_explicit(&m->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&m->head, memory_order_acquire);
+    if (tail - head == MAILBOX_SLOTS) return -1;
+    MailboxEntry *e = &m->slots[tail & (MAILBOX_SLOTS - 1)];
+    e->action = action;
+    e->at_us = at_us;
+    // publish the entry before the consumer can see the new tail
+    atomic_store_explicit(&m->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int mailbox_pop(Mailbox *m, MailboxEntry *out) {
+    unsigned head = atomic_load_explicit(&m->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&m->tail, memory_order_acquire);
+    if (head == tail) return 0;
+    *out = m->slots[head & (MAILBOX_SLOTS - 1)];
+    // the slot may be reused once the producer sees the new head
+    atomic_store_explicit(&m->head, head + 1, memory_order_release);
+    return 1;
+}
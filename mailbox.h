@@ -0,0 +1,28 @@
+// mailbox.h
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+#define MAILBOX_SLOTS 16 // power of two; far more than a player can type ahead
+
+typedef struct {
+    int action;       // PlayerAction
+    uint64_t at_us;   // monotonic_us() when the frame was read
+} MailboxEntry;
+
+// Lock-free single-producer/single-consumer queue of seat actions: the
+// reactor pushes, the table's worker pops. head and tail only ever grow and
+// live on separate cache lines so the two threads don't share one.
+typedef struct {
+    _Alignas(64) atomic_uint tail;   // written by the producer
+    _Alignas(64) atomic_uint head;   // written by the consumer
+    MailboxEntry slots[MAILBOX_SLOTS];
+} Mailbox;
+
+void mailbox_init(Mailbox *m);
+int mailbox_push(Mailbox *m, int action, uint64_t at_us); // producer; -1 when full
+int mailbox_pop(Mailbox *m, MailboxEntry *out);           // consumer; 0 when empty
+
+#endif // MAILBOX_H
@@ -0,0 +1,336 @@
+// micro_bench.c
+// The library's hot calls one at a time: framing, card and hand helpers, the
+// shuffle and a loopback round trip. Reports ns/op and heap allocations/op;
+// with -c/-f the results are appended to a history file and compared with
+// the previous entry, so a change can be measured against the commit before.
+#include "common.h"
+#include "frame.h"
+#include "deck.h"
+#include "rng.h"
+#include <stdatomic.h>
+#include <netinet/tcp.h>
+
+#define BENCH_REPS 5          // best of, to ride out scheduler noise
+#define FRAME_BYTES 64        // a typical STATE/CARD text frame
+#define DECODE_FRAMES ((4 + MAX_PAYLOAD) / (4 + FRAME_BYTES)) // as many as one reader buffer holds
+#define BENCH_HANDS 4096
+#define MAX_CARDS 12
+#define MAX_BENCHES 16
+
+// ------------------ allocation counting ------------------
+
+// Linked with -Wl,--wrap=malloc,... so every call from this program and the
+// library lands here first. Counts are global; the echo thread shares them.
+static _Atomic uint64_t allocs;
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t n);
+void __real_free(void *p);
+
+void *__wrap_malloc(size_t n) {
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __real_malloc(n);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t n) {
+    atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+    return __real_realloc(p, n);
+}
+
+void __wrap_free(void *p) {
+    __real_free(p);
+}
+
+// ------------------ benches ------------------
+
+typedef uint64_t (*BenchFn)(uint64_t iters); // returns a checksum
+
+typedef struct {
+    const char *name;
+    BenchFn fn;
+    uint64_t iters;
+    double ns;      // best per-op time
+    double allocs;  // per op
+} Bench;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char payload[FRAME_BYTES];
+static uint8_t wire[DECODE_FRAMES * (4 + FRAME_BYTES)];
+static Card hands[BENCH_HANDS][MAX_CARDS];
+static uint8_t sizes[BENCH_HANDS];
+
+static uint64_t bench_frame_encode(uint64_t iters) {
+    uint8_t out[4 + FRAME_BYTES];
+    uint64_t sink = 0;
+    for (uint64_t i = 0; i < iters; ++i) {
+        payload[0] = (char)i;
+        sink += frame_put(out, payload, FRAME_BYTES);
+        sink += out[4];
+    }
+    return sink;
+}
+
+static uint64_t bench_frame_decode(uint64_t iters) {
+    static FrameReader r;
+    FrameView v;
+    uint64_t sink = 0, done = 0;
+    frame_reader_init(&r);
+    while (done < iters) {
+        // stands in for frame_fill: a read() that brought a batch of frames
+        memcpy(r.buf, wire, sizeof(wire));
+        r.len = sizeof(wire);
+        r.off = 0;
+        while (frame_next(&r, &v) == FRAME_OK) {
+            sink += v.len + (uint8_t)v.data[0];
+            done++;
+        }
+    }
+    return sink;
+}
+
+static uint64_t bench_card_to_str(uint64_t iters) {
+    char buf[4];
+    uint64_t sink = 0;
+    for (uint64_t i = 0; i < iters; ++i) {
+        card_to_str((Card)(i % 52), buf);
+        sink += (uint8_t)buf[0];
+    }
+    return sink;
+}
+
+static uint64_t bench_hand_value(uint64_t iters) {
+    uint64_t sink = 0;
+    for (uint64_t i = 0; i < iters; ++i) {
+        uint64_t k = i & (BENCH_HANDS - 1);
+        sink += (uint64_t)hand_value(hands[k], sizes[k]);
+    }
+    return sink;
+}
+
+static uint64_t shuffle(uint64_t iters, int decks) {
+    static Shoe s;
+    Rng rng;
+    rng_seed(&rng, RNG_XOSHIRO, 7);
+    shoe_init(&s, decks, 75);
+    uint64_t sink = 0;
+    for (uint64_t i = 0; i < iters; ++i) {
+        shoe_shuffle(&s, &rng);
+        sink += s.cards[0];
+    }
+    return sink;
+}
+
+static uint64_t bench_shuffle_1(uint64_t iters) { return shuffle(iters, 1); }
+static uint64_t bench_shuffle_6(uint64_t iters) { return shuffle(iters, 6); }
+
+// ------------------ loopback ------------------
+
+static int client_fd = -1;
+
+// Echoes every frame back unchanged, the way a server answers a command
+static void *echo_main(void *arg) {
+    int fd = *(int*)arg;
+    static FrameReader r;
+    uint8_t out[4 + MAX_PAYLOAD];
+    FrameView v;
+    frame_reader_init(&r);
+    while (frame_recv(fd, &r, &v) >= 0) {
+        if (write_all(fd, out, frame_put(out, v.data, v.len)) < 0) break;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int loopback_open(pthread_t *echo) {
+    static int server_fd;
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (lfd < 0) return -1;
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t alen = sizeof(addr);
+    if (bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(lfd, 1) < 0 ||
+        getsockname(lfd, (struct sockaddr*)&addr, &alen) < 0) {
+        close(lfd);
+        return -1;
+    }
+    client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_fd < 0 || connect(client_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(lfd);
+        return -1;
+    }
+    server_fd = accept(lfd, NULL, NULL);
+    close(lfd);
+    if (server_fd < 0) return -1;
+    int one = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(server_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return pthread_create(echo, NULL, echo_main, &server_fd) == 0 ? 0 : -1;
+}
+
+static uint64_t bench_loopback_frame(uint64_t iters) {
+    static FrameReader r;
+    FrameView v;
+    uint64_t sink = 0;
+    frame_reader_init(&r);
+    for (uint64_t i = 0; i < iters; ++i) {
+        if (send_msg(client_fd, "ACTION HIT") < 0 || frame_recv(client_fd, &r, &v) < 0) return 0;
+        sink += v.len;
+    }
+    return sink;
+}
+
+// recv_msg mallocs every payload; frame_recv above parses in place
+static uint64_t bench_loopback_recv_msg(uint64_t iters) {
+    uint64_t sink = 0;
+    for (uint64_t i = 0; i < iters; ++i) {
+        char *msg = NULL;
+        if (send_msg(client_fd, "ACTION HIT") < 0 || recv_msg(client_fd, &msg) < 0) return 0;
+        sink += (uint8_t)msg[0];
+        free(msg);
+    }
+    return sink;
+}
+
+static Bench benches[] = {
+    { "frame_encode",      bench_frame_encode,      20000000, 0, 0 },
+    { "frame_decode",      bench_frame_decode,      20000000, 0, 0 },
+    { "card_to_str",       bench_card_to_str,       20000000, 0, 0 },
+    { "hand_value",        bench_hand_value,        20000000, 0, 0 },
+    { "shuffle_1deck",     bench_shuffle_1,           200000, 0, 0 },
+    { "shuffle_6deck",     bench_shuffle_6,            50000, 0, 0 },
+    { "loopback_frame",    bench_loopback_frame,       20000, 0, 0 },
+    { "loopback_recv_msg", bench_loopback_recv_msg,    20000, 0, 0 },
+};
+#define NUM_BENCHES ((int)(sizeof(benches) / sizeof(benches[0])))
+
+_Static_assert(sizeof(benches) / sizeof(benches[0]) <= MAX_BENCHES, "raise MAX_BENCHES");
+
+static void run(Bench *b, uint64_t *sink) {
+    b->ns = 0;
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        uint64_t a0 = atomic_load(&allocs);
+        double t0 = now_sec();
+        *sink += b->fn(b->iters);
+        double ns = (now_sec() - t0) * 1e9 / (double)b->iters;
+        b->allocs = (double)(atomic_load(&allocs) - a0) / (double)b->iters;
+        if (r == 0 || ns < b->ns) b->ns = ns;
+    }
+}
+
+// ------------------ history ------------------
+
+// History rows: label <TAB> bench <TAB> ns/op <TAB> allocs/op. The baseline
+// is the newest label in the file other than `label` itself.
+typedef struct {
+    char name[32];
+    double ns, allocs;
+} Prev;
+
+static int load_previous(const char *path, const char *label, char *prev_label, size_t cap, Prev *prev) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char line[256], lab[64], name[32];
+    double ns, al;
+    int n = 0;
+    prev_label[0] = '\0';
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "%63s\t%31s\t%lf\t%lf", lab, name, &ns, &al) != 4 || strcmp(lab, label) == 0) continue;
+        if (strcmp(lab, prev_label) != 0) {
+            snprintf(prev_label, cap, "%s", lab); // a newer run starts
+            n = 0;
+        }
+        if (n < MAX_BENCHES) {
+            snprintf(prev[n].name, sizeof(prev[n].name), "%s", name);
+            prev[n].ns = ns;
+            prev[n].allocs = al;
+            n++;
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static const Prev *find_prev(const Prev *prev, int n, const char *name) {
+    for (int i = 0; i < n; ++i)
+        if (strcmp(prev[i].name, name) == 0) return &prev[i];
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-c label -f history.tsv]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *label = NULL, *path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:f:")) != -1) {
+        switch (opt) {
+        case 'c': label = optarg; break;
+        case 'f': path = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (!label != !path || (label && strpbrk(label, " \t\n"))) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Rng rng;
+    rng_seed(&rng, RNG_XOSHIRO, 1);
+    for (int i = 0; i < FRAME_BYTES; ++i) payload[i] = (char)('A' + i % 26);
+    for (int i = 0; i < DECODE_FRAMES; ++i) frame_put(wire + i * (4 + FRAME_BYTES), payload, FRAME_BYTES);
+    for (int i = 0; i < BENCH_HANDS; ++i) {
+        sizes[i] = (uint8_t)(2 + rng_bounded(&rng, 4));
+        for (int k = 0; k < sizes[i]; ++k) hands[i][k] = (Card)rng_bounded(&rng, 52);
+    }
+
+    pthread_t echo;
+    if (loopback_open(&echo) < 0) {
+        perror("loopback");
+        return 1;
+    }
+
+    uint64_t sink = 0;
+    for (int i = 0; i < NUM_BENCHES; ++i) run(&benches[i], &sink);
+    shutdown(client_fd, SHUT_RDWR);
+    pthread_join(echo, NULL);
+    close(client_fd);
+
+    char prev_label[64] = "";
+    Prev prev[MAX_BENCHES];
+    int nprev = path ? load_previous(path, label, prev_label, sizeof(prev_label), prev) : 0;
+
+    if (nprev) printf("%-18s %10s %10s %10s   vs %s\n", "bench", "ns/op", "allocs/op", "change", prev_label);
+    else printf("%-18s %10s %10s\n", "bench", "ns/op", "allocs/op");
+    for (int i = 0; i < NUM_BENCHES; ++i) {
+        const Bench *b = &benches[i];
+        const Prev *p = find_prev(prev, nprev, b->name);
+        printf("%-18s %10.2f %10.2f", b->name, b->ns, b->allocs);
+        if (p && p->ns > 0) printf(" %+9.1f%%%s", (b->ns - p->ns) * 100.0 / p->ns,
+                                   b->allocs != p->allocs ? "  (allocs changed)" : "");
+        printf("\n");
+    }
+    printf("(checksum %" PRIu64 ")\n", sink % 1000);
+
+    if (path) {
+        FILE *f = fopen(path, "a");
+        if (!f) {
+            perror(path);
+            return 1;
+        }
+        for (int i = 0; i < NUM_BENCHES; ++i)
+            fprintf(f, "%s\t%s\t%.2f\t%.3f\n", label, benches[i].name, benches[i].ns, benches[i].allocs);
+        fclose(f);
+    }
+    return 0;
+}
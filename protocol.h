@@ -5,7 +5,7 @@
 #include "common.h"
 
 // messages from server -> client (payload is ASCII text)
-#define MSG_WELCOME "WELCOME"        // WELCOME <player_id>
+#define MSG_WELCOME "WELCOME"        // WELCOME, then "<name> <player_id> <session>"
 #define MSG_WAITING "WAITING"        // WAITING <connected>/<needed>
 #define MSG_GAME_START "GAME_START"
 #define MSG_DEAL "DEAL"              // DEAL <card1> <card2>
@@ -13,15 +13,79 @@
 #define MSG_REQUEST_ACTION "REQUEST_ACTION"
 #define MSG_CARD "CARD"              // CARD <card>
 #define MSG_BUSTED "BUSTED"
-#define MSG_RESULT "RESULT"          // RESULT <WIN|LOSE|PUSH> <player_total> <dealer_total>
+#define MSG_RESULT "RESULT"          // RESULT <WIN|LOSE|PUSH> <player_total> <dealer_total> <paid> <balance>, one per hand
 #define MSG_BROADCAST "BROADCAST"
 #define MSG_ERROR "ERROR"
 #define MSG_GOODBYE "GOODBYE"
+#define MSG_ADVICE "ADVICE"          // ADVICE <STAND|HIT|DOUBLE|SPLIT> <hand_value> <ev_stand> <ev_hit> <ev_double> <ev_split>, "-" for a move the hand can't make
+#define MSG_PING "PING"              // the connection has been quiet; answer PONG to stay connected
+#define MSG_BANKROLL "BANKROLL"      // BANKROLL <balance> <bet>: after WELCOME and in reply to BET
+#define MSG_SPLIT "SPLIT"            // SPLIT <card1> <card2>: your pair is now two hands, played in turn
+#define MSG_RESYNC "RESYNC"          // RESYNC <round> <turn_player_id|0> <hand> <hands> then per hand <stake> <ncards> <cards...>
+
+// spectator feed (after WATCH): every seat's play, no hints
+#define MSG_WATCHING "WATCHING"      // WATCHING <table_id>
+#define MSG_SEAT "SEAT"              // SEAT <player_id> <DEAL c1 c2|TURN|CARD c|BUSTED|RESULT ...>
+#define MSG_DEALER "DEALER"          // DEALER SHOWS <c1> <c2> / DEALER HITS <c>
 
 // messages from client -> server
 #define CMD_JOIN "JOIN"              // JOIN <name>
-#define CMD_ACTION "ACTION"          // ACTION HIT / ACTION STAND
+#define CMD_ACTION "ACTION"          // ACTION HIT / STAND / DOUBLE / SPLIT
 #define CMD_QUIT "QUIT"
 #define CMD_CHAT "CHAT"
+#define CMD_JOIN_BIN "JOIN_BIN"      // JOIN_BIN <name>: switch this connection to the binary protocol
+#define CMD_HINT "HINT"              // ask for basic-strategy advice on the current hand
+#define CMD_PONG "PONG"              // reply to PING
+#define CMD_BET "BET"                // BET <chips>: stake from the next deal on (MIN_BET..MAX_BET, a multiple of BLACKJACK_PAYS_DEN); BET alone shows BANKROLL
+#define CMD_WATCH "WATCH"            // WATCH <table_id>: follow a table as a spectator instead of joining
+#define CMD_WATCH_BIN "WATCH_BIN"    // WATCH_BIN <table_id>: the same, with binary frames
+#define CMD_RESUME "RESUME"          // RESUME <session>: instead of JOIN, take back a seat held after a dropped connection
+#define CMD_RESUME_BIN "RESUME_BIN"  // RESUME_BIN <session>: the same, with binary frames
+
+// A session token names the seat it can take back: u16 table_id, u8
+// player_id, u64 secret, all in network order. Text form: 22 hex digits.
+#define SESSION_TOKEN_LEN 11
+
+// Binary protocol, selected per connection by JOIN_BIN (the JOIN_BIN frame
+// itself is ASCII). Framing is unchanged; a payload is a 1-byte opcode
+// followed by fixed fields. Cards travel as raw Card bytes (0..51) and
+// integers in network order; chip counts are capped at UINT32_MAX.
+
+// server -> client
+#define OP_WELCOME 0x01       // u8 player_id, session token (SESSION_TOKEN_LEN bytes), name bytes
+#define OP_TURN 0x02          // YOUR_TURN + REQUEST_ACTION in one frame
+#define OP_DEAL 0x03          // Card, Card
+#define OP_CARD 0x04          // Card
+#define OP_BUSTED 0x05
+#define OP_RESULT 0x06        // u8 outcome (0 WIN, 1 LOSE, 2 PUSH), u8 player_total, u8 dealer_total, u32 paid, u32 balance
+#define OP_DEALER_SHOW 0x07   // Card, Card
+#define OP_DEALER_HIT 0x08    // Card
+#define OP_BROADCAST 0x09     // text bytes
+#define OP_ERROR 0x0A         // text bytes
+#define OP_ADVICE 0x0B        // u8 move (0 stand, 1 hit, 2 double, 3 split), u8 hand_value, i16 ev_stand, ev_hit, ev_double, ev_split (thousandths, ADVICE_NONE for a move the hand can't make)
+#define OP_WATCHING 0x0C      // u16 table_id
+#define OP_SEAT_EVENT 0x0D    // spectators: u8 player_id (0 = dealer), then a player frame (OP_DEAL ... OP_RESULT)
+#define OP_PING 0x0E
+#define OP_BANKROLL 0x0F      // u32 balance, u32 bet
+#define OP_SPLIT_DEAL 0x10    // Card, Card
+#define OP_RESYNC 0x11        // u32 round, u8 turn player_id (0 none), u8 hand, u8 hands, then per hand u32 stake, u8 ncards, Cards
+
+// client -> server
+#define OP_HIT 0x41
+#define OP_STAND 0x42
+#define OP_QUIT 0x43
+#define OP_CHAT 0x44          // text bytes
+#define OP_HINT 0x45
+#define OP_PONG 0x46
+#define OP_DOUBLE 0x47
+#define OP_SPLIT 0x48
+#define OP_BET 0x49           // u32 chips (as for BET), or nothing to ask for BANKROLL
+
+#define ADVICE_NONE INT16_MIN // OP_ADVICE: the hand can't make that move
+
+typedef enum {
+    PROTO_ASCII = 0,
+    PROTO_BINARY
+} ProtocolMode;
 
 #endif // PROTOCOL_H
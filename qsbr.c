@@ -0,0 +1,76 @@
+// qsbr.c
+#include "qsbr.h"
+
+int qsbr_init(Qsbr *q, int nreaders) {
+    memset(q, 0, sizeof(*q));
+    q->readers = aligned_alloc(_Alignof(QsbrReader), (size_t)nreaders * sizeof(QsbrReader));
+    q->snap = calloc((size_t)nreaders, sizeof(*q->snap));
+    if (!q->readers || !q->snap) return -1;
+    for (int i = 0; i < nreaders; ++i) atomic_init(&q->readers[i].epoch, 0);
+    q->nreaders = nreaders;
+    pthread_mutex_init(&q->lock, NULL);
+    return 0;
+}
+
+QsbrReader *qsbr_reader(Qsbr *q, int i) {
+    return &q->readers[i];
+}
+
+void qsbr_quiescent(QsbrReader *r) {
+    atomic_fetch_add(&r->epoch, 2);
+}
+
+void qsbr_offline(QsbrReader *r) {
+    atomic_fetch_add(&r->epoch, 1);
+}
+
+void qsbr_online(QsbrReader *r) {
+    atomic_fetch_add(&r->epoch, 1);
+}
+
+static void batch_push(QsbrBatch *b, void *p) {
+    if (b->len == b->cap) {
+        int cap = b->cap ? b->cap * 2 : 16;
+        void **grown = realloc(b->items, (size_t)cap * sizeof(*grown));
+        if (!grown) {
+            // can't track it: leaking is safe, freeing early is not
+            perror("realloc");
+            return;
+        }
+        b->items = grown;
+        b->cap = cap;
+    }
+    b->items[b->len++] = p;
+}
+
+void qsbr_retire(Qsbr *q, void *p) {
+    pthread_mutex_lock(&q->lock);
+    batch_push(&q->current, p);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// Caller holds q->lock
+static void poll_locked(Qsbr *q) {
+    if (q->waiting.len > 0) {
+        for (int i = 0; i < q->nreaders; ++i) {
+            uint64_t then = q->snap[i];
+            // unchanged and online: that reader may still hold an old pointer
+            if (!(then & 1) && atomic_load(&q->readers[i].epoch) == then) return;
+        }
+        for (int i = 0; i < q->waiting.len; ++i) free(q->waiting.items[i]);
+        q->waiting.len = 0;
+    }
+    if (q->current.len == 0) return;
+    // start a grace period for everything retired so far
+    QsbrBatch tmp = q->waiting;
+    q->waiting = q->current;
+    q->current = tmp;
+    for (int i = 0; i < q->nreaders; ++i) q->snap[i] = atomic_load(&q->readers[i].epoch);
+}
+
+void qsbr_poll(Qsbr *q) {
+    // whoever holds the lock is about to do the same work
+    if (pthread_mutex_trylock(&q->lock) != 0) return;
+    poll_locked(q);
+    pthread_mutex_unlock(&q->lock);
+}
@@ -0,0 +1,46 @@
+// qsbr.h
+#ifndef QSBR_H
+#define QSBR_H
+
+#include "common.h"
+#include <stdatomic.h>
+
+// Quiescent-state-based reclamation for read-mostly snapshots.
+// Readers load a published pointer and may use it until their next
+// quiescent point; they never lock or write shared state. Reclaimers retire
+// replaced snapshots and free them once every reader has passed a quiescent
+// point (or was offline) since the swap. Any thread may reclaim; a mutex
+// keeps the batches consistent, and a reclaimer that also reads must be a
+// registered reader itself.
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t epoch; // odd while offline
+} QsbrReader;
+
+typedef struct {
+    void **items;
+    int len, cap;
+} QsbrBatch;
+
+typedef struct {
+    QsbrReader *readers;
+    int nreaders;
+    QsbrBatch current;  // retired since the last grace period started
+    QsbrBatch waiting;  // retired before it, freed when it ends
+    uint64_t *snap;     // reader epochs when `waiting` started
+    pthread_mutex_t lock; // reclaimer side
+} Qsbr;
+
+int qsbr_init(Qsbr *q, int nreaders);
+QsbrReader *qsbr_reader(Qsbr *q, int i);
+
+// reader side
+void qsbr_quiescent(QsbrReader *r); // holds no snapshot right now
+void qsbr_offline(QsbrReader *r);   // about to block; holds no snapshot until qsbr_online
+void qsbr_online(QsbrReader *r);
+
+// reclaimer side (any thread)
+void qsbr_retire(Qsbr *q, void *p); // free(p) once no reader can still see it
+void qsbr_poll(Qsbr *q);            // call regularly: ends grace periods, frees; skips if another thread is polling
+
+#endif // QSBR_H
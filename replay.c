@@ -0,0 +1,257 @@
+// replay.c
+// Re-plays a server journal (-j) through the server's own table code
+// (table.c, deck.c, rules.c), headless and without sockets or timers, and
+// checks every step against the record. Each session's START record gives
+// the seed, so rebuilding the tables rebuilds every shoe; the recorded
+// rounds, stakes, actions, timeouts and leaves are the only inputs. Cards,
+// busts, dealer draws, results and payouts must then come out identical,
+// so any difference means the rules, the payouts or the shuffle changed. Tables are
+// independent and are split across threads.
+#include "common.h"
+#include "table.h"
+#include "journal.h"
+#include "rng.h"
+
+struct Conn { int unused; }; // seats only need to look occupied
+static Conn replay_conn;
+
+typedef struct {
+    uint64_t rounds, hands, records;
+    int diverged; // tables that stopped matching
+} ReplayStats;
+
+typedef struct {
+    pthread_t thread;
+    int index, nthreads;
+    ReplayStats stats;
+} ReplayThread;
+
+// The session being replayed, read-only while the threads run
+static const JournalRecord *recs;
+static GameState *tables;
+static int num_tables;
+static uint32_t *by_table;   // record indexes grouped by table
+static size_t *table_start;  // table i's are by_table[table_start[i] .. table_start[i + 1])
+static int only_table = -1;
+
+static int is_input(const JournalRecord *r) {
+    return r->type == JR_ROUND || r->type == JR_ACTION || r->type == JR_LEAVE;
+}
+
+// Everything but the timestamps must match, and a result's payout too
+static int same_record(const JournalRecord *a, const JournalRecord *b) {
+    return a->type == b->type && a->seat == b->seat && a->round == b->round && a->table == b->table &&
+           a->shoe_top == b->shoe_top && memcmp(a->data, b->data, sizeof(a->data)) == 0 &&
+           (a->type != JR_RESULT || a->read_us == b->read_us);
+}
+
+// The round's stakes are inputs too: each seat bets what its JR_DEAL says
+static void set_stakes(GameState *t, const uint32_t *idx, size_t n, size_t round_at) {
+    const JournalRecord *round = &recs[idx[round_at]];
+    for (size_t k = round_at + 1; k < n; ++k) {
+        const JournalRecord *r = &recs[idx[k]];
+        if (r->round != round->round || r->type == JR_HOLE) break;
+        if (r->type != JR_DEAL || r->seat >= MAX_PLAYERS) continue;
+        uint32_t stake;
+        memcpy(&stake, &r->data[2], sizeof(stake));
+        atomic_store_explicit(&t->players[r->seat].bet, stake, memory_order_relaxed);
+    }
+}
+
+// Hand a recorded input to the table the way the worker would have
+static void feed(GameState *t, const JournalRecord *r) {
+    switch (r->type) {
+    case JR_ROUND: {
+        Roster *ro = atomic_load_explicit(&t->roster, memory_order_relaxed);
+        ro->seated = 0;
+        for (int i = 0; i < MAX_PLAYERS; ++i) {
+            int in = (r->data[0] >> i) & 1;
+            ro->seats[i].conn = in ? &replay_conn : NULL;
+            ro->seated += in;
+        }
+        if (t->phase == PHASE_PAUSE) table_on_timeout(t); // the pause ran out
+        else table_advance(t);
+        break;
+    }
+    case JR_ACTION:
+        if (r->data[1]) table_on_seat_timeout(t, r->seat);
+        else table_on_action(t, r->seat, (PlayerAction)r->data[0], monotonic_us());
+        break;
+    case JR_LEAVE:
+        table_on_leave(t, r->seat);
+        break;
+    }
+}
+
+static void report_divergence(const JournalRecord *want, const JournalRecord *got) {
+    char a[128], b[128] = "(nothing)";
+    journal_format(want, a, sizeof(a));
+    if (got) journal_format(got, b, sizeof(b));
+    printf("table %u round %u diverged\n  journal: %s\n  replay:  %s\n", want->table, want->round, a, b);
+}
+
+// Replays one table; 0 if it matched to the end of its records
+static int replay_table(int ti, JournalRing *ring, ReplayStats *st) {
+    GameState *t = &tables[ti];
+    const uint32_t *idx = &by_table[table_start[ti]];
+    size_t n = table_start[ti + 1] - table_start[ti];
+    size_t next_input = 0;
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    t->journal = ring;
+
+    for (size_t k = 0; k < n; ++k) {
+        const JournalRecord *want = &recs[idx[k]];
+        unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        if (head == atomic_load_explicit(&ring->tail, memory_order_relaxed)) {
+            // replay is caught up: the next recorded input produces what follows
+            if (next_input < k) next_input = k;
+            while (next_input < n && !is_input(&recs[idx[next_input]])) next_input++;
+            if (next_input < n) {
+                if (recs[idx[next_input]].type == JR_ROUND) set_stakes(t, idx, n, next_input);
+                feed(t, &recs[idx[next_input++]]);
+            }
+            if (head == atomic_load_explicit(&ring->tail, memory_order_relaxed)) {
+                report_divergence(want, NULL);
+                return -1;
+            }
+        }
+        const JournalRecord *got = &ring->slots[head & (JOURNAL_RING_SLOTS - 1)];
+        if (!same_record(want, got)) {
+            report_divergence(want, got);
+            return -1;
+        }
+        atomic_store_explicit(&ring->head, head + 1, memory_order_relaxed);
+        st->records++;
+        if (want->type == JR_ROUND) st->rounds++;
+        if (want->type == JR_RESULT) st->hands++;
+    }
+    return 0;
+}
+
+static void *replay_thread(void *arg) {
+    ReplayThread *rt = arg;
+    JournalRing ring;
+    ring.slots = malloc(JOURNAL_RING_SLOTS * sizeof(JournalRecord));
+    if (!ring.slots) {
+        perror("malloc");
+        rt->stats.diverged = 1;
+        return NULL;
+    }
+    for (int i = rt->index; i < num_tables; i += rt->nthreads) {
+        if (only_table >= 0 && i + 1 != only_table) continue;
+        if (replay_table(i, &ring, &rt->stats) < 0) rt->stats.diverged++;
+    }
+    free(ring.slots);
+    return NULL;
+}
+
+// Rebuild the session's tables exactly as the server's main() did
+static int build_tables(const JournalRecord *start) {
+    uint16_t n;
+    memcpy(&n, &start->data[3], sizeof(n));
+    num_tables = n;
+    tables = aligned_alloc(_Alignof(GameState), (size_t)num_tables * sizeof(*tables));
+    if (!tables) return -1;
+    memset(tables, 0, (size_t)num_tables * sizeof(*tables));
+    Rng streams;
+    rng_seed(&streams, (RngKind)start->data[2], start->read_us);
+    for (int i = 0; i < num_tables; ++i) {
+        init_game_state(&tables[i], i + 1, start->data[0], start->data[1], &streams);
+        tables[i].parallel = (start->data[5] & JOURNAL_PARALLEL) != 0;
+    }
+    return 0;
+}
+
+static void free_tables(void) {
+    for (int i = 0; i < num_tables; ++i) {
+        free(atomic_load(&tables[i].roster));
+        pthread_mutex_destroy(&tables[i].lock);
+    }
+    free(tables);
+}
+
+// Group the session's records by table, keeping their order
+static int index_session(size_t begin, size_t end) {
+    table_start = calloc((size_t)num_tables + 1, sizeof(*table_start));
+    by_table = malloc((end - begin + 1) * sizeof(*by_table));
+    if (!table_start || !by_table) return -1;
+    for (size_t i = begin; i < end; ++i)
+        if (recs[i].table >= 1 && recs[i].table <= num_tables) table_start[recs[i].table]++;
+    for (int i = 1; i <= num_tables; ++i) table_start[i] += table_start[i - 1];
+    for (size_t i = begin; i < end; ++i)
+        if (recs[i].table >= 1 && recs[i].table <= num_tables) by_table[table_start[recs[i].table - 1]++] = (uint32_t)i;
+    // the fill pass moved each start to the next table's; shift back
+    memmove(&table_start[1], &table_start[0], (size_t)num_tables * sizeof(*table_start));
+    table_start[0] = 0;
+    return 0;
+}
+
+static double now_sec(void) {
+    return (double)monotonic_us() / 1e6;
+}
+
+static void usage(const char *pname) {
+    printf("Usage: %s [-j threads] [-t table] journal\n", pname);
+}
+
+int main(int argc, char **argv) {
+    int nthreads = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:t:h")) != -1) {
+        switch (opt) {
+        case 'j': nthreads = atoi(optarg); break;
+        case 't': only_table = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc) { usage(argv[0]); return 1; }
+    if (nthreads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    table_log = 0;
+
+    size_t n, map_len;
+    void *map;
+    recs = journal_map(argv[optind], &n, &map, &map_len);
+    if (!recs) { perror(argv[optind]); return 1; }
+    ReplayThread *threads = calloc((size_t)nthreads, sizeof(*threads));
+    if (!threads) { perror("calloc"); return 1; }
+
+    ReplayStats total = { 0, 0, 0, 0 };
+    int sessions = 0;
+    double t0 = now_sec();
+    for (size_t s = 0; s < n; ) {
+        if (recs[s].type != JR_START) { s++; continue; } // nothing to rebuild from
+        size_t e = s + 1;
+        while (e < n && recs[e].type != JR_START) e++;
+        if (build_tables(&recs[s]) < 0 || index_session(s + 1, e) < 0) { perror("malloc"); return 1; }
+        for (int i = 0; i < nthreads; ++i) {
+            threads[i] = (ReplayThread){ .index = i, .nthreads = nthreads };
+            pthread_create(&threads[i].thread, NULL, replay_thread, &threads[i]);
+        }
+        for (int i = 0; i < nthreads; ++i) {
+            pthread_join(threads[i].thread, NULL);
+            total.rounds += threads[i].stats.rounds;
+            total.hands += threads[i].stats.hands;
+            total.records += threads[i].stats.records;
+            total.diverged += threads[i].stats.diverged;
+        }
+        free_tables();
+        free(by_table);
+        free(table_start);
+        sessions++;
+        s = e;
+    }
+    double secs = now_sec() - t0;
+
+    printf("%d session%s, %" PRIu64 " rounds, %" PRIu64 " hands, %" PRIu64 " records in %.3f s (%.0f rounds/s)\n",
+           sessions, sessions == 1 ? "" : "s", total.rounds, total.hands, total.records, secs,
+           secs > 0 ? (double)total.rounds / secs : 0.0);
+    if (total.diverged) printf("%d table%s diverged\n", total.diverged, total.diverged == 1 ? "" : "s");
+    else printf("all outcomes match\n");
+    free(threads);
+    journal_unmap(map, map_len);
+    return total.diverged ? 2 : 0;
+}
@@ -0,0 +1,131 @@
+// rng.c
+#include "rng.h"
+
+static uint32_t rotl32(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+// splitmix64 spreads a single seed word over the generator state
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+int rng_parse_kind(const char *name, RngKind *kind) {
+    if (strcmp(name, "xoshiro") == 0) *kind = RNG_XOSHIRO;
+    else if (strcmp(name, "chacha") == 0) *kind = RNG_CHACHA;
+    else return -1;
+    return 0;
+}
+
+const char *rng_kind_name(RngKind kind) {
+    return kind == RNG_CHACHA ? "chacha" : "xoshiro";
+}
+
+uint64_t rng_entropy(void) {
+    uint64_t seed = 0;
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd >= 0) {
+        ssize_t n = read(fd, &seed, sizeof(seed));
+        close(fd);
+        if (n == (ssize_t)sizeof(seed)) return seed;
+    }
+    // no urandom: weak, but still differs between runs
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+}
+
+// ------------------ xoshiro256** ------------------
+
+// Advance by 2^128 draws
+static void xoshiro_jump(uint64_t s[4]) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+    };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    for (int i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+            if (jump[i] & (1ull << b)) {
+                t[0] ^= s[0]; t[1] ^= s[1]; t[2] ^= s[2]; t[3] ^= s[3];
+            }
+            rng_xoshiro_next(s);
+        }
+    }
+    memcpy(s, t, sizeof(t));
+}
+
+// ------------------ ChaCha20 ------------------
+
+#define QR(a, b, c, d) \
+    a += b; d ^= a; d = rotl32(d, 16); \
+    c += d; b ^= c; b = rotl32(b, 12); \
+    a += b; d ^= a; d = rotl32(d, 8);  \
+    c += d; b ^= c; b = rotl32(b, 7)
+
+static void chacha_refill(Rng *r) {
+    static const uint32_t sigma[4] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+    uint32_t in[16], x[16];
+    memcpy(in, sigma, sizeof(sigma));
+    memcpy(in + 4, r->u.chacha.key, sizeof(r->u.chacha.key));
+    in[12] = (uint32_t)r->u.chacha.counter;
+    in[13] = (uint32_t)(r->u.chacha.counter >> 32);
+    in[14] = 0; // nonce
+    in[15] = 0;
+    memcpy(x, in, sizeof(in));
+    for (int i = 0; i < 10; ++i) {
+        QR(x[0], x[4], x[8],  x[12]);
+        QR(x[1], x[5], x[9],  x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8],  x[13]);
+        QR(x[3], x[4], x[9],  x[14]);
+    }
+    for (int i = 0; i < 16; ++i) r->u.chacha.block[i] = x[i] + in[i];
+    r->u.chacha.counter++;
+    r->u.chacha.pos = 0;
+}
+
+uint64_t rng_chacha_next(Rng *r) {
+    if (r->u.chacha.pos > 14) chacha_refill(r);
+    uint32_t lo = r->u.chacha.block[r->u.chacha.pos++];
+    uint32_t hi = r->u.chacha.block[r->u.chacha.pos++];
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// ------------------ interface ------------------
+
+void rng_seed(Rng *r, RngKind kind, uint64_t seed) {
+    memset(r, 0, sizeof(*r));
+    r->kind = kind;
+    if (kind == RNG_CHACHA) {
+        for (int i = 0; i < 8; i += 2) {
+            uint64_t w = splitmix64(&seed);
+            r->u.chacha.key[i] = (uint32_t)w;
+            r->u.chacha.key[i + 1] = (uint32_t)(w >> 32);
+        }
+        r->u.chacha.pos = 16;
+    } else {
+        for (int i = 0; i < 4; ++i) r->u.s[i] = splitmix64(&seed);
+    }
+}
+
+void rng_split(Rng *parent, Rng *child) {
+    if (parent->kind == RNG_CHACHA) {
+        memset(child, 0, sizeof(*child));
+        child->kind = RNG_CHACHA;
+        for (int i = 0; i < 8; i += 2) {
+            uint64_t w = rng_chacha_next(parent);
+            child->u.chacha.key[i] = (uint32_t)w;
+            child->u.chacha.key[i + 1] = (uint32_t)(w >> 32);
+        }
+        child->u.chacha.pos = 16;
+    } else {
+        *child = *parent;
+        xoshiro_jump(parent->u.s);
+    }
+}
@@ -0,0 +1,70 @@
+// rng.h
+#ifndef RNG_H
+#define RNG_H
+
+#include "common.h"
+
+typedef enum {
+    RNG_XOSHIRO = 0,  // xoshiro256**: fastest, fine for play and simulation
+    RNG_CHACHA        // ChaCha20 keystream: unpredictable, for audited tables
+} RngKind;
+
+// One random stream. Streams split from the same parent never overlap:
+// xoshiro children are 2^128 draws apart, ChaCha children get a fresh key
+// drawn from the parent's keystream.
+// Not thread-safe: give every table and thread its own stream.
+typedef struct {
+    RngKind kind;
+    union {
+        uint64_t s[4];            // xoshiro state
+        struct {
+            uint32_t key[8];
+            uint64_t counter;     // block counter
+            uint32_t block[16];   // current keystream block
+            int pos;              // next unused word in block, 16 = empty
+        } chacha;
+    } u;
+} Rng;
+
+int rng_parse_kind(const char *name, RngKind *kind); // "xoshiro" / "chacha"; -1 if unknown
+const char *rng_kind_name(RngKind kind);
+uint64_t rng_entropy(void);                          // seed material from /dev/urandom
+void rng_seed(Rng *r, RngKind kind, uint64_t seed);
+void rng_split(Rng *parent, Rng *child);             // child gets the next independent stream
+uint64_t rng_chacha_next(Rng *r);
+
+// The per-draw path is inline: a shuffle calls it once per card.
+
+static inline uint64_t rng_xoshiro_next(uint64_t s[4]) {
+    uint64_t x = s[1] * 5;
+    uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+static inline uint64_t rng_next(Rng *r) {
+    return r->kind == RNG_CHACHA ? rng_chacha_next(r) : rng_xoshiro_next(r->u.s);
+}
+
+// Uniform in [0, n) without modulo bias (Lemire's multiply-shift); the
+// division only runs in the rare rejection case.
+static inline uint32_t rng_bounded(Rng *r, uint32_t n) {
+    uint64_t m = (rng_next(r) >> 32) * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+        uint32_t threshold = -n % n;
+        while (low < threshold) {
+            m = (rng_next(r) >> 32) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif // RNG_H
@@ -0,0 +1,80 @@
+// rng_bench.c
+// Compares the shoe shuffle under each generator with the old rand_r path,
+// and checks that every card is equally likely to land on top.
+#include "common.h"
+#include "deck.h"
+#include "rng.h"
+
+#define BENCH_SHUFFLES 200000
+#define BENCH_DRAWS 50000000
+#define FAIR_SHUFFLES 520000 // 10000 expected hits per card
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// The shuffle as it was: rand_r with modulo bias
+static void shuffle_rand_r(Shoe *s, unsigned *seedp) {
+    for (int i = s->size - 1; i > 0; --i) {
+        int j = rand_r(seedp) % (i + 1);
+        Card tmp = s->cards[i]; s->cards[i] = s->cards[j]; s->cards[j] = tmp;
+    }
+    s->top = 0;
+}
+
+// Chi-square of the top card over FAIR_SHUFFLES single-deck shuffles
+// (51 degrees of freedom: ~51 expected, above ~80 is suspicious).
+static double top_card_chi2(Rng *rng, unsigned *seedp) {
+    static Shoe s;
+    long hits[52] = { 0 };
+    shoe_init(&s, 1, 100);
+    for (int n = 0; n < FAIR_SHUFFLES; ++n) {
+        if (rng) shoe_shuffle(&s, rng);
+        else shuffle_rand_r(&s, seedp);
+        hits[s.cards[0]]++;
+    }
+    double expect = FAIR_SHUFFLES / 52.0, chi2 = 0;
+    for (int i = 0; i < 52; ++i) chi2 += (hits[i] - expect) * (hits[i] - expect) / expect;
+    return chi2;
+}
+
+static void bench(const char *name, Rng *rng, unsigned *seedp) {
+    static Shoe s;
+    shoe_init(&s, 6, 75);
+    uint64_t sink = 0;
+
+    double t0 = now_sec();
+    for (int n = 0; n < BENCH_SHUFFLES; ++n) {
+        if (rng) shoe_shuffle(&s, rng);
+        else shuffle_rand_r(&s, seedp);
+        sink += s.cards[0];
+    }
+    double shuffle_ns = (now_sec() - t0) * 1e9 / BENCH_SHUFFLES;
+
+    t0 = now_sec();
+    for (int n = 0; n < BENCH_DRAWS; ++n) sink += rng ? rng_next(rng) : (uint64_t)rand_r(seedp);
+    double draw_ns = (now_sec() - t0) * 1e9 / BENCH_DRAWS;
+
+    printf("%-8s %10.1f ns/6-deck shuffle %8.2f ns/draw   top-card chi2 %6.1f  (%" PRIu64 ")\n",
+           name, shuffle_ns, draw_ns, top_card_chi2(rng, seedp), sink % 10);
+}
+
+int main(int argc, char **argv) {
+    uint64_t seed = argc > 1 ? strtoull(argv[1], NULL, 0) : rng_entropy();
+    printf("seed %" PRIu64 "\n", seed);
+
+    unsigned legacy = (unsigned)seed;
+    bench("rand_r", NULL, &legacy);
+
+    Rng master, r;
+    rng_seed(&master, RNG_XOSHIRO, seed);
+    rng_split(&master, &r);
+    bench("xoshiro", &r, NULL);
+
+    rng_seed(&master, RNG_CHACHA, seed);
+    rng_split(&master, &r);
+    bench("chacha", &r, NULL);
+    return 0;
+}
@@ -0,0 +1,31 @@
+// rules.c
+#include "rules.h"
+
+// Dealer rules: hit while < 17, counting a soft ace as 11 (hits soft 16, stands on soft 17)
+int dealer_hits(HandState dealer) {
+    return hand_state_value(dealer) < DEALER_STANDS_ON;
+}
+
+Outcome hand_outcome(int player_total, int dealer_total) {
+    if (player_total > 21) return OUTCOME_LOSE;
+    if (dealer_total > 21) return OUTCOME_WIN;
+    if (player_total > dealer_total) return OUTCOME_WIN;
+    if (player_total < dealer_total) return OUTCOME_LOSE;
+    return OUTCOME_PUSH;
+}
+
+Outcome natural_outcome(int player_total, int player_natural, int dealer_total, int dealer_natural) {
+    if (player_natural || dealer_natural) {
+        if (player_natural && dealer_natural) return OUTCOME_PUSH;
+        return player_natural ? OUTCOME_WIN : OUTCOME_LOSE;
+    }
+    return hand_outcome(player_total, dealer_total);
+}
+
+int64_t hand_return(Outcome o, int natural, int64_t stake) {
+    switch (o) {
+    case OUTCOME_WIN: return stake + (natural ? stake * BLACKJACK_PAYS_NUM / BLACKJACK_PAYS_DEN : stake);
+    case OUTCOME_PUSH: return stake;
+    default: return 0;
+    }
+}
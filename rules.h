@@ -0,0 +1,31 @@
+// rules.h
+#ifndef RULES_H
+#define RULES_H
+
+#include "deck.h"
+
+// House rules shared by the server and the simulator, so a rule change
+// is validated offline against exactly the code that deals live hands.
+
+#define DEALER_STANDS_ON 17 // dealer hits below this
+#define BLACKJACK_PAYS_NUM 3 // a natural pays 3:2
+#define BLACKJACK_PAYS_DEN 2 // bets come in steps of this, so a natural always pays whole chips
+#define MIN_BET 10
+#define MAX_BET 500
+#define STARTING_BANKROLL 1000 // chips for a player the ledger hasn't seen
+
+typedef enum {
+    OUTCOME_WIN = 0,
+    OUTCOME_LOSE,
+    OUTCOME_PUSH
+} Outcome;
+
+int dealer_hits(HandState dealer);
+Outcome hand_outcome(int player_total, int dealer_total); // busted players lose even if the dealer busts
+// The same, with naturals (two-card 21, never after a split): a natural beats
+// any other 21, and the dealer's beats every hand but another natural. The
+// dealer doesn't peek, so doubled and split stakes lose to it too.
+Outcome natural_outcome(int player_total, int player_natural, int dealer_total, int dealer_natural);
+int64_t hand_return(Outcome o, int natural, int64_t stake); // chips paid back, stake included
+
+#endif // RULES_H
@@ -1,634 +1,1688 @@
 // server.c
+#define _DEFAULT_SOURCE // SO_REUSEPORT
 #include "common.h"
 #include "protocol.h"
 #include "deck.h"
+#include "table.h"
+#include "frame.h"
+#include "qsbr.h"
+#include "stats.h"
+#include "journal.h"
+#include "ledger.h"
 #include <stdarg.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <math.h>
 
-#define MIN_PLAYERS 2
-#define BACKLOG 10
-#define RESHUFFLE_THRESHOLD 15
+#define DEFAULT_TABLES 128
+#define DEFAULT_BACKLOG 1024       // -q; the kernel caps it at net.core.somaxconn
+#define DEFAULT_HANDSHAKES 4096    // -H; conns waiting for JOIN, over all reactors
+#define ADMIN_BACKLOG 10
+#define MAX_EVENTS 64              // epoll events handled per wakeup
+#define OUT_BUF_INIT 4096          // initial output ring per connection
+#define OUT_BUF_MAX (256 * 1024)   // a client this far behind gets dropped
+#define STATS_REPORT_MAX 4096
+#define FEED_MAX 256               // frames queued per spectator before it is dropped
+#define FEED_IOV 64                // spectator frames per writev
 
-typedef enum {
-    PLAYER_STATE_EMPTY = 0,
-    PLAYER_STATE_CONNECTED,
-    PLAYER_STATE_IN_GAME,
-} PlayerState;
+// One encoded frame, length prefix included, queued by reference on every
+// spectator that should get it. Whoever drops the last reference frees it.
+typedef struct {
+    atomic_int refs;
+    uint32_t len;
+    uint8_t data[];
+} SharedFrame;
+
+typedef struct Reactor Reactor;
+
+// Per-connection state. Its reactor owns the socket and the input side:
+// frames are parsed incrementally out of `rd`, so a client that trickles
+// bytes never blocks anyone else. Any thread may queue output. Conns are
+// pooled and never freed, so a Player keeps a pointer plus the generation
+// it was seated with and output for a recycled conn is simply dropped.
+struct Conn {
+    int fd;
+    uint32_t gen;                  // bumped every time the conn is recycled
+    Reactor *reactor;              // the one that accepted it; pooled there too
+    GameState *table;              // set by the lobby on JOIN
+    int slot;                      // index into table->players, -1 until JOIN
+    FrameReader rd;                // frames are parsed in place from here
+    ProtocolMode proto;            // fixed by the JOIN variant
+    uint64_t accepted_us;          // for the accept -> WELCOME latency
+
+    pthread_mutex_t out_lock;      // guards the output side and fd/gen changes
+    uint8_t *out;                  // ring buffer of encoded frames
+    size_t out_cap, out_head, out_len;
+    int flush_queued;              // on some thread's flush list
+    int want_write;                // EPOLLOUT armed; the reactor finishes the flush
+    int closing;                   // overflowed, the reactor will close it
+    Conn *next_free;
 
+    // spectators only; the feed goes out after `out`
+    GameState *watching;           // reactor only; NULL for players
+    SharedFrame **feed;            // ring of FEED_MAX shared frames, under out_lock
+    unsigned feed_head, feed_len;
+    size_t feed_off;               // bytes of the head frame already written
+
+    // liveness, reactor only
+    Timer idle;                    // JOIN deadline, then the keepalive check
+    uint64_t last_rx_ms;           // last time anything arrived
+    int ping_sent;                 // PING is out and unanswered
+    Conn *hs_prev, *hs_next;       // on the reactor's handshake list until JOIN/WATCH
+    int handshaking;
+};
+
+// Requests the reactor hands to the worker that owns a table
 typedef enum {
-    PLAYER_ACTION_NONE = 0,
-    PLAYER_ACTION_HIT,
-    PLAYER_ACTION_STAND
-} PlayerAction;
+    TMSG_JOIN = 0,
+    TMSG_LEAVE,
+    TMSG_AWAY,   // the seat's connection dropped; hold it for grace_ms
+    TMSG_RESUME  // a held seat was taken back
+} TableMsgType;
 
 typedef struct {
-    int sockfd;
-    pthread_t thread;
-    int id; // 1-based
-    char name[MAX_NAME_LEN];
-    PlayerState state;
-
-    // per-round
-    Card hand[12];
-    int hand_size;
-    int is_busted;
-    int has_stood;
+    TableMsgType type;
+    GameState *table;
+    int seat;
+} TableMsg;
 
-    // action synchronization
-    pthread_mutex_t action_lock;
-    pthread_cond_t action_cond;
-    PlayerAction pending_action;
-    int awaiting_action; // coordinator sets to 1 to indicate awaiting
+// A table worker owns a fixed subset of the tables and advances all of their
+// round state machines from one thread, woken by its eventfd or its timers.
+typedef struct {
+    pthread_t thread;
+    int efd;                 // eventfd doorbell, written after each post
+    TimerWheel wheel;
+    pthread_mutex_t lock;    // guards the inbox
+    TableMsg *inbox;
+    int inbox_len, inbox_cap;
+    // one bit per owned table with queued seat actions; set by the reactor,
+    // taken by the worker. Bit k is table (k * num_workers + worker index).
+    atomic_uint_least64_t *ready;
+    int ready_words;
+    QsbrReader *qsbr;        // roster snapshots are only held while online
+} Worker;
 
-    int alive; // 1 = connection open and responsive, 0 = disconnected
-} Player;
+// An I/O reactor: one thread with its own listening socket, epoll set and
+// timer wheel. Every reactor binds the port with SO_REUSEPORT, so the kernel
+// spreads new connections over them and a storm of reconnects is accepted
+// in parallel. A conn stays on the reactor that accepted it.
+struct Reactor {
+    pthread_t thread;
+    int index;
+    int listen_fd;
+    int epoll_fd;
+    TimerWheel wheel;        // every connection's idle timer
+    Conn *free_list;         // recycled conns
+    Conn *hs_head, *hs_tail; // accepted but no JOIN/WATCH yet, oldest first
+    int handshakes;
+    uint8_t *kick;           // per worker: doorbell owed at the end of this batch
+    QsbrReader *qsbr;        // reads rosters (chat) and retires them on seat changes
+    Rng rng;                 // session secrets
+};
 
+// A seat held for RESUME after its connection dropped. The timer runs on
+// the wheel of the worker that owns the table.
 typedef struct {
-    Player players[MAX_PLAYERS];
-    pthread_mutex_t lock;
-    int connected_count;
-    Card deck[52];
-    int deck_top;
-    unsigned rand_seed;
-} GameState;
-
-GameState G;
-int listen_fd = -1;
-int server_running = 1;
+    Timer timer;
+    GameState *table;
+    int seat;
+} SeatHold;
+
+GameState *tables;
+int num_tables = DEFAULT_TABLES;
+Worker *workers;
+int num_workers = 0; // 0 = one per online CPU
+Reactor *reactors;
+int num_reactors = 0; // -A, 0 = one per 4 online CPUs
+pthread_mutex_t lobby_lock = PTHREAD_MUTEX_INITIALIZER;
+static int backlog = DEFAULT_BACKLOG;
+static int max_handshakes; // per reactor, -H split between them
+static int admin_fd = -1;
+static const char *admin_path; // -a: Unix socket that answers with a stats report
+static Journal journal;
+static unsigned keepalive_ms = KEEPALIVE_SEC * 1000; // -k, 0 = never
+static unsigned lobby_ms = LOBBY_TIMEOUT_SEC * 1000; // -l, 0 = never
+static unsigned grace_ms = RESUME_GRACE_SEC * 1000; // -g, 0 = free a dropped seat at once
+static SeatHold *holds; // MAX_PLAYERS per table
+static const char *journal_path; // -j: append a binary round journal here
+static Ledger ledger;
+static const char *ledger_path; // -b: bankroll log
+volatile sig_atomic_t server_running = 1;
 
 static void handle_sigint(int sig) {
     (void)sig;
-    server_running = 0;
-    if (listen_fd >= 0) close(listen_fd);
+    server_running = 0; // every loop wakes at least once a second to notice
 }
 
-// ------------------ helper implementations ------------------
+// ------------------ connection output ------------------
 
-ssize_t write_all(int fd, const void *buf, size_t count) {
-    const uint8_t *p = buf;
-    size_t left = count;
-    while (left > 0) {
-        ssize_t n = write(fd, p, left);
-        if (n <= 0) {
-            if (errno == EINTR) continue;
-            return -1;
-        }
-        left -= (size_t)n;
-        p += n;
-    }
-    return (ssize_t)count;
-}
+// Conns this thread queued output on since its last flush_pending()
+static _Thread_local Conn **flush_list;
+static _Thread_local int flush_len, flush_cap;
 
-ssize_t read_all(int fd, void *buf, size_t count) {
-    uint8_t *p = buf;
-    size_t left = count;
-    while (left > 0) {
-        ssize_t n = read(fd, p, left);
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            return -1;
-        }
-        if (n == 0) return (ssize_t)(count - left); // EOF
-        left -= (size_t)n;
-        p += n;
+static void conn_flush_locked(Conn *c);
+
+// Make room for `extra` more bytes, linearizing the ring when it grows
+static int out_reserve(Conn *c, size_t extra) {
+    size_t need = c->out_len + extra;
+    if (need <= c->out_cap) return 0;
+    size_t cap = c->out_cap ? c->out_cap : OUT_BUF_INIT;
+    while (cap < need) cap *= 2;
+    uint8_t *buf = malloc(cap);
+    if (!buf) return -1;
+    size_t first = c->out_cap - c->out_head;
+    if (first > c->out_len) first = c->out_len;
+    if (c->out_len) {
+        memcpy(buf, c->out + c->out_head, first);
+        memcpy(buf + first, c->out, c->out_len - first);
     }
-    return (ssize_t)count;
+    free(c->out);
+    c->out = buf;
+    c->out_cap = cap;
+    c->out_head = 0;
+    return 0;
 }
 
-int send_msg(int fd, const char *msg) {
-    uint32_t len = (uint32_t)strlen(msg);
-    uint32_t nlen = htonl(len);
-    if (write_all(fd, &nlen, sizeof(nlen)) < 0) return -1;
-    if (write_all(fd, msg, len) < 0) return -1;
-    return 0;
+static void out_put(Conn *c, const void *src, size_t n) {
+    size_t tail = (c->out_head + c->out_len) % c->out_cap;
+    size_t first = c->out_cap - tail;
+    if (first > n) first = n;
+    memcpy(c->out + tail, src, first);
+    memcpy(c->out, (const uint8_t*)src + first, n - first);
+    c->out_len += n;
 }
 
-int recv_msg(int fd, char **out_buf) {
-    uint32_t nlen;
-    ssize_t r = read_all(fd, &nlen, sizeof(nlen));
-    if (r <= 0) return -1;
-    uint32_t len = ntohl(nlen);
-    if (len == 0) {
-        *out_buf = strdup("");
-        return 0;
-    }
-    if (len > MAX_PAYLOAD) {
-        // too big; drain and return error
-        char tmp[256];
-        size_t to_read = len;
-        while (to_read > 0) {
-            ssize_t rr = read(fd, tmp, sizeof(tmp) < to_read ? sizeof(tmp) : to_read);
-            if (rr <= 0) break;
-            to_read -= rr;
+// Put the conn on this thread's flush list. Caller holds out_lock.
+static void conn_schedule_flush(Conn *c) {
+    if (c->flush_queued || c->want_write) return;
+    if (flush_len == flush_cap) {
+        int cap = flush_cap ? flush_cap * 2 : 64;
+        Conn **grown = realloc(flush_list, (size_t)cap * sizeof(*grown));
+        if (!grown) {
+            conn_flush_locked(c); // no list to defer on, send now
+            return;
         }
-        return -1;
+        flush_list = grown;
+        flush_cap = cap;
     }
-    char *buf = malloc(len + 1);
-    if (!buf) return -1;
-    if (read_all(fd, buf, len) != (ssize_t)len) {
-        free(buf);
-        return -1;
+    c->flush_queued = 1;
+    flush_list[flush_len++] = c;
+}
+
+// Queue one length-prefixed frame; it goes out on this thread's next flush.
+// Output for a conn that has been recycled since `gen` is dropped.
+static void conn_send_bytes(Conn *c, uint32_t gen, const void *msg, size_t len) {
+    uint32_t nlen = htonl((uint32_t)len);
+    pthread_mutex_lock(&c->out_lock);
+    if (c->gen != gen || c->fd < 0 || c->closing) {
+        pthread_mutex_unlock(&c->out_lock);
+        return;
+    }
+    if (c->out_len + 4 + len > OUT_BUF_MAX || out_reserve(c, 4 + len) < 0) {
+        // slow consumer: stop buffering and let the reactor close it
+        c->closing = 1;
+        shutdown(c->fd, SHUT_RDWR);
+        pthread_mutex_unlock(&c->out_lock);
+        return;
     }
-    buf[len] = '\0';
-    *out_buf = buf;
-    return (int)len;
+    out_put(c, &nlen, sizeof(nlen));
+    out_put(c, msg, len);
+    conn_schedule_flush(c);
+    pthread_mutex_unlock(&c->out_lock);
 }
 
-// ------------------ deck.c content (deck utilities) ------------------
+static SharedFrame *shared_frame_new(const void *payload, size_t len) {
+    SharedFrame *f = malloc(sizeof(*f) + 4 + len);
+    if (!f) return NULL;
+    atomic_init(&f->refs, 1);
+    f->len = (uint32_t)frame_put(f->data, payload, (uint32_t)len);
+    return f;
+}
 
-void init_deck(Card deck[52]) {
-    for (int i = 0; i < 52; ++i) deck[i] = (Card)i;
+static void shared_frame_put(SharedFrame *f) {
+    if (atomic_fetch_sub_explicit(&f->refs, 1, memory_order_acq_rel) == 1) free(f);
 }
 
-void shuffle_deck(Card deck[52], unsigned *seedp) {
-    for (int i = 51; i > 0; --i) {
-        int j = rand_r(seedp) % (i + 1);
-        Card tmp = deck[i]; deck[i] = deck[j]; deck[j] = tmp;
+// Drop everything still queued on a spectator. Caller holds out_lock.
+static void feed_clear(Conn *c) {
+    for (; c->feed_len > 0; c->feed_len--) {
+        shared_frame_put(c->feed[c->feed_head]);
+        c->feed_head = (c->feed_head + 1) % FEED_MAX;
     }
+    c->feed_off = 0;
 }
 
-Card deal_card(Card deck[52], int *top_index) {
-    if (*top_index >= 52) {
-        // caller should reshuffle before
-        return 0xFF;
+// Queue a shared frame on a spectator without copying it. A spectator that
+// lets FEED_MAX frames pile up is closed rather than buffered for.
+static void conn_send_shared(Conn *c, uint32_t gen, SharedFrame *f) {
+    pthread_mutex_lock(&c->out_lock);
+    if (c->gen != gen || c->fd < 0 || c->closing || !c->feed) {
+        pthread_mutex_unlock(&c->out_lock);
+        return;
+    }
+    if (c->feed_len == FEED_MAX) {
+        c->closing = 1;
+        shutdown(c->fd, SHUT_RDWR);
+        stats_count(STAT_WATCH_DROPS, 1);
+        pthread_mutex_unlock(&c->out_lock);
+        return;
     }
-    return deck[(*top_index)++];
+    atomic_fetch_add_explicit(&f->refs, 1, memory_order_relaxed);
+    c->feed[(c->feed_head + c->feed_len++) % FEED_MAX] = f;
+    conn_schedule_flush(c);
+    pthread_mutex_unlock(&c->out_lock);
+}
+
+static void conn_send(Conn *c, uint32_t gen, const char *msg) {
+    conn_send_bytes(c, gen, msg, strlen(msg));
+}
+
+// An opcode followed by raw bytes, for binary-protocol connections
+static void conn_send_op(Conn *c, uint32_t gen, uint8_t op, const void *data, size_t len) {
+    uint8_t buf[1 + MAX_PAYLOAD];
+    if (len > MAX_PAYLOAD - 1) len = MAX_PAYLOAD - 1;
+    buf[0] = op;
+    memcpy(buf + 1, data, len);
+    conn_send_bytes(c, gen, buf, 1 + len);
 }
 
-void card_to_str(Card c, char *out) {
-    if (c > 51) { strcpy(out, "??"); return; }
-    const char *suits = "SHDC"; // spade, heart, diamond, club
-    int suit = c / 13;
-    int rank = c % 13; // 0 = Ace, 9 = 10, 10=J,11=Q,12=K
-    char rbuf[4];
-    if (rank == 0) strcpy(rbuf, "A");
-    else if (rank >= 1 && rank <= 8) sprintf(rbuf, "%d", rank + 1);
-    else if (rank == 9) strcpy(rbuf, "10");
-    else if (rank == 10) strcpy(rbuf, "J");
-    else if (rank == 11) strcpy(rbuf, "Q");
-    else strcpy(rbuf, "K");
-    sprintf(out, "%c%s", suits[suit], rbuf);
+static void conn_set_events(Conn *c, uint32_t events) {
+    struct epoll_event ev = { .events = events, .data.ptr = c };
+    epoll_ctl(c->reactor->epoll_fd, EPOLL_CTL_MOD, c->fd, &ev);
 }
 
-int hand_value(const Card *hand, int n) {
-    int total = 0, aces = 0;
-    for (int i = 0; i < n; ++i) {
-        int r = hand[i] % 13;
-        if (r == 0) { aces++; total += 11; }
-        else if (r >= 10) total += 10;
-        else total += (r + 1);
+// Write everything queued with one writev: the ring (two iovecs when it
+// wraps), then a spectator's shared frames straight from where they sit.
+// If the socket fills up, EPOLLOUT is armed and the reactor finishes later.
+// Caller holds out_lock.
+static void conn_flush_locked(Conn *c) {
+    while (c->out_len > 0 || c->feed_len > 0) {
+        struct iovec iov[2 + FEED_IOV];
+        int niov = 0;
+        if (c->out_len > 0) {
+            size_t first = c->out_cap - c->out_head;
+            if (first > c->out_len) first = c->out_len;
+            iov[niov++] = (struct iovec){ c->out + c->out_head, first };
+            if (c->out_len > first) iov[niov++] = (struct iovec){ c->out, c->out_len - first };
+        }
+        for (unsigned i = 0; i < c->feed_len && i < FEED_IOV; ++i) {
+            SharedFrame *f = c->feed[(c->feed_head + i) % FEED_MAX];
+            size_t off = i == 0 ? c->feed_off : 0;
+            iov[niov++] = (struct iovec){ f->data + off, f->len - off };
+        }
+        ssize_t n = writev(c->fd, iov, niov);
+        stats_count(STAT_SEND_CALLS, 1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!c->want_write) {
+                    c->want_write = 1;
+                    conn_set_events(c, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+                }
+                return;
+            }
+            // peer is gone; the reactor notices on its next read
+            c->out_len = 0;
+            feed_clear(c);
+            break;
+        }
+        stats_count(STAT_SEND_BYTES, (uint64_t)n);
+        size_t done = (size_t)n < c->out_len ? (size_t)n : c->out_len;
+        if (done) {
+            c->out_head = (c->out_head + done) % c->out_cap;
+            c->out_len -= done;
+        }
+        size_t left = (size_t)n - done;
+        while (left > 0) {
+            SharedFrame *f = c->feed[c->feed_head];
+            size_t rest = f->len - c->feed_off;
+            if (left < rest) {
+                c->feed_off += left;
+                break;
+            }
+            left -= rest;
+            shared_frame_put(f);
+            c->feed_head = (c->feed_head + 1) % FEED_MAX;
+            c->feed_len--;
+            c->feed_off = 0;
+        }
+    }
+    c->out_head = 0;
+    if (c->want_write) {
+        c->want_write = 0;
+        conn_set_events(c, EPOLLIN | EPOLLRDHUP);
     }
-    while (total > 21 && aces > 0) {
-        total -= 10;
-        aces--;
+}
+
+// Flush every conn this thread queued output on; one syscall per socket
+static void flush_pending(void) {
+    for (int i = 0; i < flush_len; ++i) {
+        Conn *c = flush_list[i];
+        pthread_mutex_lock(&c->out_lock);
+        c->flush_queued = 0;
+        if (c->fd >= 0 && !c->want_write) conn_flush_locked(c);
+        pthread_mutex_unlock(&c->out_lock);
     }
-    return total;
+    flush_len = 0;
 }
 
 // ------------------ server utilities ------------------
 
-void init_game_state(GameState *g) {
-    pthread_mutex_init(&g->lock, NULL);
-    g->connected_count = 0;
-    g->rand_seed = (unsigned)time(NULL) ^ (unsigned)getpid();
-    init_deck(g->deck);
-    shuffle_deck(g->deck, &g->rand_seed);
-    g->deck_top = 0;
-    for (int i = 0; i < MAX_PLAYERS; ++i) {
-        g->players[i].sockfd = -1;
-        g->players[i].id = i+1;
-        g->players[i].state = PLAYER_STATE_EMPTY;
-        g->players[i].hand_size = 0;
-        g->players[i].is_busted = 0;
-        g->players[i].has_stood = 0;
-        g->players[i].pending_action = PLAYER_ACTION_NONE;
-        g->players[i].awaiting_action = 0;
-        g->players[i].alive = 0;
-        pthread_mutex_init(&g->players[i].action_lock, NULL);
-        pthread_cond_init(&g->players[i].action_cond, NULL);
+// Pick a table for a joining player: top up a partly filled table first so
+// rounds can start, otherwise open an empty one. Caller holds lobby_lock.
+static GameState *lobby_pick_table(void) {
+    GameState *empty = NULL;
+    for (int i = 0; i < num_tables; ++i) {
+        GameState *t = &tables[i];
+        if (t->connected_count >= MAX_PLAYERS) continue;
+        if (t->connected_count > 0) return t;
+        if (!empty) empty = t;
     }
+    return empty;
 }
 
-int find_free_slot(GameState *g) {
-    for (int i = 0; i < MAX_PLAYERS; ++i) {
-        if (g->players[i].state == PLAYER_STATE_EMPTY) return i;
+// Coordinator utilities. Recipients come from a roster snapshot, so no
+// table lock is held while queueing; a seat that has since been vacated
+// fails the conn_gen check and is skipped.
+void send_to_player(const RosterSeat *s, const char *msg) {
+    conn_send(s->conn, s->conn_gen, msg);
+}
+
+// send generic text to player (prefixed as BROADCAST for simplicity)
+void send_text_to_player(const RosterSeat *s, const char *text) {
+    if (s->proto == PROTO_BINARY) {
+        conn_send_op(s->conn, s->conn_gen, OP_BROADCAST, text, strlen(text));
+        return;
     }
-    return -1;
+    send_to_player(s, MSG_BROADCAST);
+    send_to_player(s, text);
 }
 
-void broadcast_msg(const char *fmt, ...) {
+// Snapshots are read by the workers and the reactors without locks and freed
+// by whichever reactor polls once every one of them has passed a quiescent point.
+static Qsbr roster_qsbr;
+
+static const Roster *roster_get(GameState *t) {
+    return atomic_load_explicit(&t->roster, memory_order_acquire);
+}
+
+// After a seat change; caller holds t->lock. Reactor threads only.
+static void roster_update(GameState *t) {
+    Roster *old = table_publish_roster(t);
+    if (old) qsbr_retire(&roster_qsbr, old);
+}
+
+void broadcast_msg(GameState *t, const char *fmt, ...) {
     char buf[MAX_PAYLOAD];
     va_list ap;
     va_start(ap, fmt);
     vsnprintf(buf, sizeof(buf), fmt, ap);
     va_end(ap);
 
-    pthread_mutex_lock(&G.lock);
+    const Roster *r = roster_get(t);
     for (int i = 0; i < MAX_PLAYERS; ++i) {
-        if (G.players[i].state != PLAYER_STATE_EMPTY && G.players[i].alive) {
-            send_msg(G.players[i].sockfd, MSG_BROADCAST " "); // not strictly needed
-            send_msg(G.players[i].sockfd, buf);
+        if (r->seats[i].conn) send_text_to_player(&r->seats[i], buf);
+    }
+}
+
+// ASCII rendering of an event: one frame, or two for the YOUR_TURN and
+// BROADCAST pairs. Returns the number of frames.
+static int encode_ascii(const TableEvent *ev, char *buf, size_t size, const char *frames[2]) {
+    static const char *outcomes[] = { "WIN", "LOSE", "PUSH" };
+    char s0[4], s1[4];
+    switch (ev->type) {
+    case EV_DEAL:
+        card_to_str(ev->cards[0], s0);
+        card_to_str(ev->cards[1], s1);
+        snprintf(buf, size, MSG_DEAL " %s %s", s0, s1);
+        frames[0] = buf;
+        return 1;
+    case EV_TURN:
+        frames[0] = MSG_YOUR_TURN;
+        frames[1] = MSG_REQUEST_ACTION;
+        return 2;
+    case EV_CARD:
+        card_to_str(ev->cards[0], s0);
+        snprintf(buf, size, MSG_CARD " %s", s0);
+        frames[0] = buf;
+        return 1;
+    case EV_BUSTED:
+        frames[0] = MSG_BUSTED;
+        return 1;
+    case EV_DEALER_SHOW:
+        card_to_str(ev->cards[0], s0);
+        card_to_str(ev->cards[1], s1);
+        snprintf(buf, size, "Dealer shows %s %s", s0, s1);
+        frames[0] = MSG_BROADCAST;
+        frames[1] = buf;
+        return 2;
+    case EV_DEALER_HIT:
+        card_to_str(ev->cards[0], s0);
+        snprintf(buf, size, "Dealer hits %s", s0);
+        frames[0] = MSG_BROADCAST;
+        frames[1] = buf;
+        return 2;
+    case EV_RESULT:
+        snprintf(buf, size, MSG_RESULT " %s %d %d %" PRId64 " %" PRId64, outcomes[ev->outcome],
+                 ev->player_total, ev->dealer_total, ev->payout, ev->balance);
+        frames[0] = buf;
+        return 1;
+    case EV_HINT: {
+        static const char *moves[] = { "STAND", "HIT", "DOUBLE", "SPLIT" };
+        char dbl[16] = "-", split[16] = "-";
+        if (!isnan(ev->ev_double)) snprintf(dbl, sizeof(dbl), "%.3f", ev->ev_double);
+        if (!isnan(ev->ev_split)) snprintf(split, sizeof(split), "%.3f", ev->ev_split);
+        snprintf(buf, size, MSG_ADVICE " %s %d %.3f %.3f %s %s", moves[ev->advice], ev->player_total,
+                 ev->ev_stand, ev->ev_hit, dbl, split);
+        frames[0] = buf;
+        return 1;
+    }
+    case EV_SPLIT:
+        card_to_str(ev->cards[0], s0);
+        card_to_str(ev->cards[1], s1);
+        snprintf(buf, size, MSG_SPLIT " %s %s", s0, s1);
+        frames[0] = buf;
+        return 1;
+    case EV_REFUSED:
+        frames[0] = MSG_ERROR;
+        frames[1] = ev->text;
+        return 2;
+    case EV_RESYNC: {
+        size_t n = (size_t)snprintf(buf, size, MSG_RESYNC " %" PRIu32 " %d %d %d", ev->round, ev->turn + 1,
+                                    ev->hand, ev->num_hands);
+        for (int k = 0; k < ev->num_hands && n < size; ++k) {
+            const Hand *h = &ev->hands[k];
+            n += (size_t)snprintf(buf + n, size - n, " %" PRId64 " %d", ev->stakes[k], h->size);
+            for (int i = 0; i < h->size && n < size; ++i) {
+                card_to_str(h->cards[i], s0);
+                n += (size_t)snprintf(buf + n, size - n, " %s", s0);
+            }
         }
+        frames[0] = buf;
+        return 1;
     }
-    pthread_mutex_unlock(&G.lock);
-}
-
-// Per-client reader thread: reads messages (JOIN handled before spawning), then loops reading frames
-void *client_reader_thread(void *arg) {
-    Player *p = (Player*)arg;
-    int fd = p->sockfd;
-    while (p->alive) {
-        char *msg = NULL;
-        int rr = recv_msg(fd, &msg);
-        if (rr <= 0) {
-            // disconnected
-            free(msg);
-            pthread_mutex_lock(&G.lock);
-            p->alive = 0;
-            p->state = PLAYER_STATE_EMPTY;
-            G.connected_count--;
-            pthread_mutex_unlock(&G.lock);
-            // notify any waiting coordinator
-            pthread_mutex_lock(&p->action_lock);
-            p->pending_action = PLAYER_ACTION_STAND; // treat as stand when missing
-            p->awaiting_action = 0;
-            pthread_cond_signal(&p->action_cond);
-            pthread_mutex_unlock(&p->action_lock);
-            close(fd);
-            printf("Player %d disconnected\n", p->id);
-            break;
+    }
+    return 0;
+}
+
+// Signed thousandths in network order; NAN goes out as ADVICE_NONE
+static void put_milli(uint8_t *out, float x) {
+    int16_t milli = isnan(x) ? ADVICE_NONE : (int16_t)(x * 1000 + (x < 0 ? -0.5f : 0.5f));
+    uint16_t v = htons((uint16_t)milli);
+    memcpy(out, &v, 2);
+}
+
+// Chips in network order, capped to fit
+static void put_chips(uint8_t *out, int64_t chips) {
+    uint32_t v = htonl(chips < 0 ? 0 : chips > UINT32_MAX ? UINT32_MAX : (uint32_t)chips);
+    memcpy(out, &v, 4);
+}
+
+// Binary rendering of an event (see protocol.h). Returns the payload length;
+// `out` must hold BIN_EVENT_MAX bytes.
+#define BIN_EVENT_MAX (8 + MAX_HANDS * (5 + MAX_HAND)) // RESYNC is the longest
+static size_t encode_binary(const TableEvent *ev, uint8_t *out) {
+    switch (ev->type) {
+    case EV_DEAL:
+        out[0] = OP_DEAL; out[1] = ev->cards[0]; out[2] = ev->cards[1];
+        return 3;
+    case EV_TURN:
+        out[0] = OP_TURN;
+        return 1;
+    case EV_CARD:
+        out[0] = OP_CARD; out[1] = ev->cards[0];
+        return 2;
+    case EV_BUSTED:
+        out[0] = OP_BUSTED;
+        return 1;
+    case EV_DEALER_SHOW:
+        out[0] = OP_DEALER_SHOW; out[1] = ev->cards[0]; out[2] = ev->cards[1];
+        return 3;
+    case EV_DEALER_HIT:
+        out[0] = OP_DEALER_HIT; out[1] = ev->cards[0];
+        return 2;
+    case EV_RESULT:
+        out[0] = OP_RESULT;
+        out[1] = (uint8_t)ev->outcome;
+        out[2] = (uint8_t)ev->player_total;
+        out[3] = (uint8_t)ev->dealer_total;
+        put_chips(out + 4, ev->payout);
+        put_chips(out + 8, ev->balance);
+        return 12;
+    case EV_HINT:
+        out[0] = OP_ADVICE;
+        out[1] = (uint8_t)ev->advice;
+        out[2] = (uint8_t)ev->player_total;
+        put_milli(out + 3, ev->ev_stand);
+        put_milli(out + 5, ev->ev_hit);
+        put_milli(out + 7, ev->ev_double);
+        put_milli(out + 9, ev->ev_split);
+        return 11;
+    case EV_SPLIT:
+        out[0] = OP_SPLIT_DEAL; out[1] = ev->cards[0]; out[2] = ev->cards[1];
+        return 3;
+    case EV_REFUSED: {
+        size_t len = strlen(ev->text);
+        if (len > BIN_EVENT_MAX - 1) len = BIN_EVENT_MAX - 1;
+        out[0] = OP_ERROR;
+        memcpy(out + 1, ev->text, len);
+        return 1 + len;
+    }
+    case EV_RESYNC: {
+        uint32_t round = htonl(ev->round);
+        out[0] = OP_RESYNC;
+        memcpy(out + 1, &round, 4);
+        out[5] = (uint8_t)(ev->turn + 1);
+        out[6] = (uint8_t)ev->hand;
+        out[7] = (uint8_t)ev->num_hands;
+        size_t n = 8;
+        for (int k = 0; k < ev->num_hands; ++k) {
+            const Hand *h = &ev->hands[k];
+            put_chips(out + n, ev->stakes[k]);
+            out[n + 4] = (uint8_t)h->size;
+            memcpy(out + n + 5, h->cards, (size_t)h->size);
+            n += 5 + (size_t)h->size;
         }
-        // parse message
-        // messages: ACTION HIT, ACTION STAND, QUIT, CHAT ...
-        if (strncmp(msg, CMD_ACTION, strlen(CMD_ACTION)) == 0) {
-            char *arg = msg + strlen(CMD_ACTION);
-            while (*arg == ' ') arg++;
-            if (strncmp(arg, "HIT", 3) == 0) {
-                pthread_mutex_lock(&p->action_lock);
-                p->pending_action = PLAYER_ACTION_HIT;
-                if (p->awaiting_action) {
-                    p->awaiting_action = 0;
-                    pthread_cond_signal(&p->action_cond);
-                }
-                pthread_mutex_unlock(&p->action_lock);
-            } else if (strncmp(arg, "STAND", 5) == 0) {
-                pthread_mutex_lock(&p->action_lock);
-                p->pending_action = PLAYER_ACTION_STAND;
-                if (p->awaiting_action) {
-                    p->awaiting_action = 0;
-                    pthread_cond_signal(&p->action_cond);
-                }
-                pthread_mutex_unlock(&p->action_lock);
+        return n;
+    }
+    }
+    return 0;
+}
+
+// A spectator's copy of an event: which seat it concerns, then what
+// happened. NULL for events spectators don't see (hints, refusals, resyncs).
+static SharedFrame *encode_watch(const TableEvent *ev, ProtocolMode proto) {
+    if (ev->type == EV_HINT || ev->type == EV_REFUSED || ev->type == EV_RESYNC) return NULL;
+    int id = ev->seat + 1; // 0: the dealer
+    if (proto == PROTO_BINARY) {
+        uint8_t bin[2 + BIN_EVENT_MAX];
+        bin[0] = OP_SEAT_EVENT;
+        bin[1] = (uint8_t)id;
+        return shared_frame_new(bin, 2 + encode_binary(ev, bin + 2));
+    }
+    char text[MAX_PAYLOAD], body[MAX_PAYLOAD], s0[4], s1[4];
+    const char *frames[2];
+    int n;
+    switch (ev->type) {
+    case EV_TURN:
+        n = snprintf(text, sizeof(text), MSG_SEAT " %d TURN", id);
+        break;
+    case EV_DEALER_SHOW:
+        card_to_str(ev->cards[0], s0);
+        card_to_str(ev->cards[1], s1);
+        n = snprintf(text, sizeof(text), MSG_DEALER " SHOWS %s %s", s0, s1);
+        break;
+    case EV_DEALER_HIT:
+        card_to_str(ev->cards[0], s0);
+        n = snprintf(text, sizeof(text), MSG_DEALER " HITS %s", s0);
+        break;
+    default: // the seat's own frame: DEAL, CARD, BUSTED, SPLIT, RESULT
+        encode_ascii(ev, body, sizeof(body), frames);
+        n = snprintf(text, sizeof(text), MSG_SEAT " %d %s", id, frames[0]);
+        break;
+    }
+    return shared_frame_new(text, n < (int)sizeof(text) ? (size_t)n : sizeof(text) - 1);
+}
+
+// Every spectator gets every event. It is encoded once per protocol and
+// queued on all of them by reference, so a big audience costs a pointer
+// per watcher rather than a formatted copy.
+static void watch_fanout(const Roster *r, const TableEvent *ev) {
+    SharedFrame *encoded[2] = { NULL, NULL }; // by ProtocolMode
+    int tried[2] = { 0, 0 };
+    for (int i = 0; i < r->watching; ++i) {
+        const RosterSeat *s = &r->watchers[i];
+        if (!tried[s->proto]) {
+            tried[s->proto] = 1;
+            encoded[s->proto] = encode_watch(ev, (ProtocolMode)s->proto);
+        }
+        if (encoded[s->proto]) conn_send_shared(s->conn, s->conn_gen, encoded[s->proto]);
+    }
+    for (int p = 0; p < 2; ++p)
+        if (encoded[p]) shared_frame_put(encoded[p]);
+}
+
+// Turn table events into protocol frames for the seated clients. Each
+// encoding is produced at most once per event, and only if someone needs it.
+static void server_emit(GameState *t, const TableEvent *ev) {
+    char text[MAX_PAYLOAD];
+    const char *frames[2];
+    int nframes = -1;
+    uint8_t bin[BIN_EVENT_MAX];
+    size_t bin_len = 0;
+
+    const Roster *r = roster_get(t);
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        const RosterSeat *s = &r->seats[i];
+        // seat events go to that seat, table-wide ones to everyone in the round
+        if (ev->seat >= 0 ? i != ev->seat : !(t->seats.active & SEAT_BIT(i))) continue;
+        if (!s->conn) continue;
+        if (s->proto == PROTO_BINARY) {
+            if (bin_len == 0) bin_len = encode_binary(ev, bin);
+            conn_send_bytes(s->conn, s->conn_gen, bin, bin_len);
+        } else {
+            if (nframes < 0) nframes = encode_ascii(ev, text, sizeof(text), frames);
+            for (int f = 0; f < nframes; ++f) send_to_player(s, frames[f]);
+        }
+    }
+    if (r->watching) watch_fanout(r, ev);
+}
+
+// ------------------ table workers ------------------
+
+// Hand a request to the worker owning the table (any thread)
+static void worker_post(GameState *t, TableMsgType type, int seat) {
+    Worker *w = &workers[t->worker];
+    pthread_mutex_lock(&w->lock);
+    if (w->inbox_len == w->inbox_cap) {
+        int cap = w->inbox_cap ? w->inbox_cap * 2 : 64;
+        TableMsg *grown = realloc(w->inbox, (size_t)cap * sizeof(*grown));
+        if (!grown) {
+            pthread_mutex_unlock(&w->lock);
+            perror("realloc");
+            return;
+        }
+        w->inbox = grown;
+        w->inbox_cap = cap;
+    }
+    w->inbox[w->inbox_len++] = (TableMsg){ .type = type, .table = t, .seat = seat };
+    pthread_mutex_unlock(&w->lock);
+    uint64_t one = 1;
+    if (write(w->efd, &one, sizeof(one)) < 0 && errno != EAGAIN) perror("eventfd write");
+}
+
+void *table_worker(void *arg) {
+    Worker *w = arg;
+    stats_attach(num_reactors + (int)(w - workers)); // the reactors' slots come first
+    TableMsg *batch = NULL;
+    int batch_cap = 0;
+    while (server_running) {
+        // sleep until posted to or the next timer is due; wake at least once a second for shutdown
+        int timeout = timer_wheel_timeout_ms(&w->wheel, monotonic_ms());
+        if (timeout < 0 || timeout > 1000) timeout = 1000;
+        struct pollfd pfd = { .fd = w->efd, .events = POLLIN };
+        qsbr_offline(w->qsbr);
+        int idle = poll(&pfd, 1, timeout) == 0;
+        qsbr_online(w->qsbr);
+        if (!idle) {
+            uint64_t v;
+            if (read(w->efd, &v, sizeof(v)) < 0 && errno != EAGAIN) perror("eventfd read");
+        }
+
+        // swap the inbox out so posters never wait on table logic
+        pthread_mutex_lock(&w->lock);
+        TableMsg *msgs = w->inbox;
+        int n = w->inbox_len, cap = w->inbox_cap;
+        w->inbox = batch;
+        w->inbox_cap = batch_cap;
+        w->inbox_len = 0;
+        pthread_mutex_unlock(&w->lock);
+        batch = msgs;
+        batch_cap = cap;
+
+        for (int i = 0; i < n; ++i) {
+            TableMsg *m = &msgs[i];
+            SeatHold *h = &holds[(m->table->id - 1) * MAX_PLAYERS + m->seat];
+            switch (m->type) {
+            case TMSG_JOIN: table_on_join(m->table); break;
+            case TMSG_LEAVE: table_on_leave(m->table, m->seat); break;
+            case TMSG_AWAY: timer_arm(&w->wheel, &h->timer, grace_ms); break;
+            case TMSG_RESUME:
+                timer_cancel(&w->wheel, &h->timer);
+                table_on_resume(m->table, m->seat);
+                break;
             }
-        } else if (strncmp(msg, CMD_QUIT, strlen(CMD_QUIT)) == 0) {
-            free(msg);
-            pthread_mutex_lock(&G.lock);
-            p->alive = 0;
-            p->state = PLAYER_STATE_EMPTY;
-            G.connected_count--;
-            pthread_mutex_unlock(&G.lock);
-            close(fd);
-            printf("Player %d quit\n", p->id);
-            break;
-        } else if (strncmp(msg, CMD_CHAT, strlen(CMD_CHAT)) == 0) {
-            // optional chat handling
-            // broadcast message to others
-            char *payload = msg + strlen(CMD_CHAT);
-            while (*payload == ' ') payload++;
-            char bcast[MAX_PAYLOAD];
-            snprintf(bcast, sizeof(bcast), "%s: %s", p->name, payload);
-            // use simple broadcast: send MSG_BROADCAST then text
-            pthread_mutex_lock(&G.lock);
-            for (int i = 0; i < MAX_PLAYERS; ++i) {
-                if (G.players[i].alive && G.players[i].sockfd != p->sockfd) {
-                    send_msg(G.players[i].sockfd, MSG_BROADCAST);
-                    send_msg(G.players[i].sockfd, bcast);
-                }
+        }
+
+        // then every table the reactor queued seat actions for
+        int index = (int)(w - workers);
+        for (int j = 0; j < w->ready_words; ++j) {
+            uint64_t bits = atomic_exchange(&w->ready[j], 0);
+            while (bits) {
+                int k = j * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                GameState *t = &tables[k * num_workers + index];
+                for (int seat = 0; seat < MAX_PLAYERS; ++seat) table_drain_actions(t, seat);
             }
-            pthread_mutex_unlock(&G.lock);
         }
-        free(msg);
+        timer_wheel_advance(&w->wheel, monotonic_ms());
+        // everything this step produced goes out in one writev per socket
+        flush_pending();
+
+        // nothing was posted: shuffle spare shoes now rather than at reshuffle time
+        if (idle) {
+            for (int i = (int)(w - workers); i < num_tables; i += num_workers)
+                table_prepare_shoe(&tables[i]);
+        }
     }
+    free(batch);
     return NULL;
 }
 
-// Coordinator utilities: send player's hand, etc.
-void send_hand_to_player(Player *p) {
-    char buf[MAX_PAYLOAD];
-    char c1[4], c2[4];
-    if (p->hand_size >= 1) card_to_str(p->hand[0], c1); else strcpy(c1,"??");
-    if (p->hand_size >= 2) card_to_str(p->hand[1], c2); else strcpy(c2,"??");
-    snprintf(buf, sizeof(buf), MSG_DEAL " %s %s", c1, c2);
-    send_msg(p->sockfd, buf);
+// ------------------ reactor (epoll event loop) ------------------
+
+static void conn_on_idle(void *arg);
+
+static Conn *conn_alloc(Reactor *r, int fd) {
+    Conn *c = r->free_list;
+    if (c) {
+        r->free_list = c->next_free;
+    } else {
+        c = calloc(1, sizeof(*c));
+        if (!c) return NULL;
+        pthread_mutex_init(&c->out_lock, NULL);
+    }
+    pthread_mutex_lock(&c->out_lock);
+    c->fd = fd;
+    pthread_mutex_unlock(&c->out_lock);
+    c->reactor = r;
+    c->table = NULL;
+    c->slot = -1;
+    c->proto = PROTO_ASCII;
+    c->watching = NULL;
+    timer_init(&c->idle, conn_on_idle, c);
+    c->last_rx_ms = monotonic_ms();
+    c->ping_sent = 0;
+    frame_reader_init(&c->rd);
+    c->next_free = NULL;
+    c->hs_prev = c->hs_next = NULL;
+    c->handshaking = 0;
+    return c;
 }
 
-// send a single card with MSG_CARD
-void send_card_to_player(Player *p, Card c) {
-    char s[4];
-    card_to_str(c, s);
-    char buf[MAX_PAYLOAD];
-    snprintf(buf, sizeof(buf), MSG_CARD " %s", s);
-    send_msg(p->sockfd, buf);
+// A reactor tracks its conns that have not sent JOIN or WATCH. Each one
+// holds a conn and its reader buffer, so only max_handshakes may wait at
+// once; the lobby deadline closes the ones that stall.
+static void handshake_add(Conn *c) {
+    Reactor *r = c->reactor;
+    c->hs_prev = r->hs_tail;
+    c->hs_next = NULL;
+    if (r->hs_tail) r->hs_tail->hs_next = c;
+    else r->hs_head = c;
+    r->hs_tail = c;
+    r->handshakes++;
+    c->handshaking = 1;
 }
 
-// send generic text to player (prefixed as BROADCAST for simplicity)
-void send_text_to_player(Player *p, const char *text) {
-    send_msg(p->sockfd, MSG_BROADCAST);
-    send_msg(p->sockfd, text);
+// JOIN or WATCH went through, or the conn is closing
+static void handshake_done(Conn *c) {
+    if (!c->handshaking) return;
+    Reactor *r = c->reactor;
+    if (c->hs_prev) c->hs_prev->hs_next = c->hs_next;
+    else r->hs_head = c->hs_next;
+    if (c->hs_next) c->hs_next->hs_prev = c->hs_prev;
+    else r->hs_tail = c->hs_prev;
+    c->hs_prev = c->hs_next = NULL;
+    r->handshakes--;
+    c->handshaking = 0;
 }
 
-void reset_player_round(Player *p) {
-    p->hand_size = 0;
-    p->is_busted = 0;
-    p->has_stood = 0;
-    p->pending_action = PLAYER_ACTION_NONE;
-    p->awaiting_action = 0;
+static int set_nonblocking(int fd) {
+    int fl = fcntl(fd, F_GETFL, 0);
+    if (fl < 0) return -1;
+    return fcntl(fd, F_SETFL, fl | O_NONBLOCK);
 }
 
-void game_loop(void);
+// Release a seat that belonged to a closed connection
+static void release_slot(GameState *t, int slot) {
+    Player *p = &t->players[slot];
+    pthread_mutex_lock(&lobby_lock);
+    pthread_mutex_lock(&t->lock);
+    p->alive = 0;
+    p->state = PLAYER_STATE_EMPTY;
+    p->conn = NULL;
+    t->connected_count--;
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    pthread_mutex_unlock(&lobby_lock);
+    // the worker forfeits the hand and moves the turn on if it was theirs
+    worker_post(t, TMSG_LEAVE, slot);
+}
 
-// Wrapper for pthread
-void *game_loop_wrapper(void *arg) {
-    (void)arg;
-    game_loop();
-    return NULL;
+// Keep a dropped player's seat, hand and stake for grace_ms. The seat
+// leaves the roster, so nothing is sent to it and it is not dealt into new
+// rounds, but the lobby won't give it away until the hold runs out.
+static void hold_slot(GameState *t, int slot) {
+    Player *p = &t->players[slot];
+    pthread_mutex_lock(&t->lock);
+    p->alive = 0;
+    p->state = PLAYER_STATE_AWAY;
+    p->conn = NULL;
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    worker_post(t, TMSG_AWAY, slot);
 }
 
-// main coordinator loop
-void game_loop() {
-    while (server_running) {
-        // Wait for at least 1 connected player
-        pthread_mutex_lock(&G.lock);
-        while (G.connected_count < MIN_PLAYERS && server_running) {
-            pthread_mutex_unlock(&G.lock);
-            sleep(1);
-            pthread_mutex_lock(&G.lock);
+// The hold ran out (owning worker). The seat may have been resumed since
+// the timer was armed; the state says.
+static void seat_hold_expired(void *arg) {
+    SeatHold *h = arg;
+    GameState *t = h->table;
+    Player *p = &t->players[h->seat];
+    pthread_mutex_lock(&lobby_lock);
+    pthread_mutex_lock(&t->lock);
+    int expired = p->state == PLAYER_STATE_AWAY;
+    if (expired) {
+        p->state = PLAYER_STATE_EMPTY;
+        p->session = 0;
+        t->connected_count--;
+    }
+    pthread_mutex_unlock(&t->lock);
+    pthread_mutex_unlock(&lobby_lock);
+    if (!expired) return;
+    printf("Table %d: player %d's seat released\n", t->id, p->id);
+    table_on_leave(t, h->seat); // forfeits a hand still in play
+}
+
+// Take a spectator off its table's list
+static void unwatch(Conn *c) {
+    GameState *t = c->watching;
+    pthread_mutex_lock(&t->lock);
+    for (int i = 0; i < t->num_watchers; ++i) {
+        if (t->watchers[i].conn == c) {
+            t->watchers[i] = t->watchers[--t->num_watchers];
+            break;
         }
-        pthread_mutex_unlock(&G.lock);
-        if (!server_running) break;
-
-        // Start a round
-        printf("Starting a new round\n");
-
-        // Reinitialize deck if necessary
-        pthread_mutex_lock(&G.lock);
-        if (G.deck_top > 52 - RESHUFFLE_THRESHOLD) {
-            init_deck(G.deck);
-            shuffle_deck(G.deck, &G.rand_seed);
-            G.deck_top = 0;
-            printf("Deck reshuffled\n");
+    }
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    c->watching = NULL;
+}
+
+static void close_conn(Conn *c, const char *why) {
+    Reactor *r = c->reactor;
+    epoll_ctl(r->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+    stats_count(STAT_CLOSES, 1);
+    if (c->slot >= 0) {
+        // anything but QUIT may be a dropped link the player comes back from
+        int hold = grace_ms && strcmp(why, "quit") != 0;
+        if (hold) hold_slot(c->table, c->slot);
+        else release_slot(c->table, c->slot);
+        printf("Table %d: player %d %s%s\n", c->table->id, c->slot + 1, why, hold ? ", seat held" : "");
+    }
+    if (c->watching) unwatch(c);
+    handshake_done(c);
+    timer_cancel(&r->wheel, &c->idle);
+    pthread_mutex_lock(&c->out_lock);
+    // best effort to deliver a final ERROR before hanging up
+    if (!c->closing && !c->want_write) conn_flush_locked(c);
+    feed_clear(c);
+    free(c->feed);
+    c->feed = NULL;
+    close(c->fd);
+    c->fd = -1;
+    c->gen++;
+    c->out_len = c->out_head = 0;
+    c->want_write = c->closing = 0;
+    pthread_mutex_unlock(&c->out_lock);
+    c->next_free = r->free_list;
+    r->free_list = c;
+}
+
+// From JOIN/WATCH on: check for silence every keepalive_ms
+static void conn_keepalive(Conn *c) {
+    if (keepalive_ms) timer_arm(&c->reactor->wheel, &c->idle, keepalive_ms);
+    else timer_cancel(&c->reactor->wheel, &c->idle);
+}
+
+// The idle timer fired. Before JOIN it is the lobby deadline. After it, a
+// connection quiet for keepalive_ms gets a PING and one more keepalive_ms
+// to answer. Reads only stamp last_rx_ms; the timer re-arms itself for
+// whatever is left, so busy connections cost nothing per frame.
+static void conn_on_idle(void *arg) {
+    Conn *c = arg;
+    if (c->slot < 0 && !c->watching) {
+        stats_count(STAT_IDLE_CLOSES, 1);
+        close_conn(c, "expired");
+        return;
+    }
+    uint64_t quiet = monotonic_ms() - c->last_rx_ms;
+    if (quiet < keepalive_ms) {
+        timer_arm(&c->reactor->wheel, &c->idle, keepalive_ms - (unsigned)quiet);
+        return;
+    }
+    if (c->ping_sent) {
+        stats_count(STAT_IDLE_CLOSES, 1);
+        close_conn(c, "timed out");
+        return;
+    }
+    if (c->proto == PROTO_BINARY) conn_send_op(c, c->gen, OP_PING, NULL, 0);
+    else conn_send(c, c->gen, MSG_PING);
+    c->ping_sent = 1;
+    timer_arm(&c->reactor->wheel, &c->idle, keepalive_ms);
+}
+
+// EPOLLOUT: the socket drained, push out what an earlier flush left behind
+static void conn_writable(Conn *c) {
+    pthread_mutex_lock(&c->out_lock);
+    conn_flush_locked(c);
+    pthread_mutex_unlock(&c->out_lock);
+}
+
+// ERROR in whichever protocol the connection speaks
+static void conn_error(Conn *c, const char *text) {
+    if (c->proto == PROTO_BINARY) {
+        conn_send_op(c, c->gen, OP_ERROR, text, strlen(text));
+        return;
+    }
+    conn_send(c, c->gen, MSG_ERROR);
+    conn_send(c, c->gen, text);
+}
+
+// BANKROLL <balance> <bet> in whichever protocol the connection speaks
+static void conn_bankroll(Conn *c, Player *p) {
+    int64_t balance = p->account ? ledger_balance(p->account) : 0;
+    int64_t bet = atomic_load_explicit(&p->bet, memory_order_relaxed);
+    if (c->proto == PROTO_BINARY) {
+        uint8_t buf[8];
+        put_chips(buf, balance);
+        put_chips(buf + 4, bet);
+        conn_send_op(c, c->gen, OP_BANKROLL, buf, sizeof(buf));
+        return;
+    }
+    char text[64];
+    snprintf(text, sizeof(text), MSG_BANKROLL " %" PRId64 " %" PRId64, balance, bet);
+    conn_send(c, c->gen, text);
+}
+
+// WELCOME with the seat's session token, then BANKROLL. Caller holds t->lock.
+static void conn_welcome(Conn *c, GameState *t, Player *p) {
+    uint8_t token[SESSION_TOKEN_LEN];
+    uint16_t tid = htons((uint16_t)t->id);
+    uint32_t hi = htonl((uint32_t)(p->session >> 32)), lo = htonl((uint32_t)p->session);
+    memcpy(token, &tid, 2);
+    token[2] = (uint8_t)p->id;
+    memcpy(token + 3, &hi, 4);
+    memcpy(token + 7, &lo, 4);
+    size_t name_len = strlen(p->name);
+    if (c->proto == PROTO_BINARY) {
+        uint8_t welc[1 + SESSION_TOKEN_LEN + MAX_NAME_LEN];
+        welc[0] = (uint8_t)p->id;
+        memcpy(welc + 1, token, sizeof(token));
+        memcpy(welc + 1 + sizeof(token), p->name, name_len);
+        conn_send_op(c, c->gen, OP_WELCOME, welc, 1 + sizeof(token) + name_len);
+    } else {
+        conn_send(c, c->gen, MSG_WELCOME);
+        char welc[MAX_PAYLOAD];
+        int n = snprintf(welc, sizeof(welc), "%s %d ", p->name, p->id);
+        for (size_t i = 0; i < sizeof(token); ++i) n += snprintf(welc + n, sizeof(welc) - (size_t)n, "%02x", token[i]);
+        conn_send(c, c->gen, welc);
+    }
+    conn_bankroll(c, p);
+}
+
+// JOIN <name> or JOIN_BIN <name>: the first frame on every connection
+static int handle_join(Conn *c, const FrameView *msg) {
+    // parse name; JOIN_BIN switches the connection to binary frames
+    uint32_t name_len;
+    const char *name;
+    if (frame_is(msg, CMD_JOIN_BIN)) {
+        c->proto = PROTO_BINARY;
+        name = frame_arg(msg, CMD_JOIN_BIN, &name_len);
+    } else if (frame_is(msg, CMD_JOIN)) {
+        name = frame_arg(msg, CMD_JOIN, &name_len);
+    } else {
+        // send error and close
+        conn_error(c, "Expected JOIN");
+        return -1;
+    }
+    if (name_len > MAX_NAME_LEN - 1) name_len = MAX_NAME_LEN - 1;
+    char pname[MAX_NAME_LEN];
+    memcpy(pname, name, name_len);
+    pname[name_len] = '\0';
+    // the bankroll follows the name from table to table and across restarts
+    Account *account = ledger_account(&ledger, pname);
+    if (!account) {
+        conn_error(c, "Server full");
+        return -1;
+    }
+
+    // assign a table and a slot
+    pthread_mutex_lock(&lobby_lock);
+    GameState *t = lobby_pick_table();
+    if (!t) {
+        pthread_mutex_unlock(&lobby_lock);
+        conn_error(c, "Server full");
+        return -1;
+    }
+    pthread_mutex_lock(&t->lock);
+    int slot = find_free_slot(t);
+    Player *p = &t->players[slot];
+    p->conn = c;
+    p->conn_gen = c->gen;
+    p->state = PLAYER_STATE_CONNECTED;
+    p->alive = 1;
+    p->proto = c->proto;
+    memcpy(p->name, pname, sizeof(p->name));
+    p->account = account;
+    atomic_store_explicit(&p->bet, MIN_BET, memory_order_relaxed);
+    do p->session = rng_next(&c->reactor->rng); while (p->session == 0);
+    conn_welcome(c, t, p);
+    stats_count(STAT_JOINS, 1);
+    stats_latency(LAT_JOIN, monotonic_us() - c->accepted_us);
+
+    // mark as in-game for rounds
+    p->state = PLAYER_STATE_IN_GAME;
+    t->connected_count++;
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    pthread_mutex_unlock(&lobby_lock);
+    worker_post(t, TMSG_JOIN, slot);
+
+    c->table = t;
+    c->slot = slot;
+    handshake_done(c);
+    conn_keepalive(c);
+    printf("Table %d: player %d connected: %s\n", t->id, p->id, p->name);
+    return 0;
+}
+
+// RESUME <session> or RESUME_BIN <session>, in place of JOIN: take back a
+// held seat with its hand. WELCOME and BANKROLL come from here, then the
+// worker sends RESYNC (and the turn prompt, if the table is waiting on it).
+static int handle_resume(Conn *c, const FrameView *msg) {
+    uint32_t len;
+    const char *arg;
+    if (frame_is(msg, CMD_RESUME_BIN)) {
+        c->proto = PROTO_BINARY;
+        arg = frame_arg(msg, CMD_RESUME_BIN, &len);
+    } else {
+        arg = frame_arg(msg, CMD_RESUME, &len);
+    }
+    uint8_t token[SESSION_TOKEN_LEN];
+    int ok = len == 2 * SESSION_TOKEN_LEN;
+    for (int i = 0; ok && i < SESSION_TOKEN_LEN; ++i) {
+        char hex[3] = { arg[2 * i], arg[2 * i + 1], '\0' };
+        char *end;
+        token[i] = (uint8_t)strtoul(hex, &end, 16);
+        ok = end == hex + 2;
+    }
+    uint16_t tid;
+    uint32_t hi, lo;
+    if (ok) {
+        memcpy(&tid, token, 2);
+        memcpy(&hi, token + 3, 4);
+        memcpy(&lo, token + 7, 4);
+        tid = ntohs(tid);
+    }
+    if (!ok || tid < 1 || tid > num_tables || token[2] < 1 || token[2] > MAX_PLAYERS) {
+        conn_error(c, "Bad session");
+        return -1;
+    }
+    uint64_t session = (uint64_t)ntohl(hi) << 32 | ntohl(lo);
+    GameState *t = &tables[tid - 1];
+    int slot = token[2] - 1;
+    Player *p = &t->players[slot];
+
+    pthread_mutex_lock(&t->lock);
+    if (p->state != PLAYER_STATE_AWAY || p->session != session) {
+        pthread_mutex_unlock(&t->lock);
+        conn_error(c, "Session expired");
+        return -1;
+    }
+    p->conn = c;
+    p->conn_gen = c->gen;
+    p->state = PLAYER_STATE_IN_GAME;
+    p->alive = 1;
+    p->proto = c->proto;
+    conn_welcome(c, t, p);
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    worker_post(t, TMSG_RESUME, slot);
+    stats_count(STAT_RESUMES, 1);
+
+    c->table = t;
+    c->slot = slot;
+    handshake_done(c);
+    conn_keepalive(c);
+    printf("Table %d: player %d resumed: %s\n", t->id, p->id, p->name);
+    return 0;
+}
+
+// WATCH <table_id> or WATCH_BIN <table_id>: follow a table's play without a
+// seat. Spectators are published with the roster and fed from server_emit.
+static int handle_watch(Conn *c, const FrameView *msg) {
+    uint32_t len;
+    const char *arg;
+    if (frame_is(msg, CMD_WATCH_BIN)) {
+        c->proto = PROTO_BINARY;
+        arg = frame_arg(msg, CMD_WATCH_BIN, &len);
+    } else {
+        arg = frame_arg(msg, CMD_WATCH, &len);
+    }
+    char idbuf[16];
+    snprintf(idbuf, sizeof(idbuf), "%.*s", (int)len, arg);
+    int id = atoi(idbuf);
+    if (id < 1 || id > num_tables) {
+        conn_error(c, "No such table");
+        return -1;
+    }
+    GameState *t = &tables[id - 1];
+
+    pthread_mutex_lock(&c->out_lock);
+    c->feed = calloc(FEED_MAX, sizeof(*c->feed));
+    c->feed_head = c->feed_len = 0;
+    c->feed_off = 0;
+    pthread_mutex_unlock(&c->out_lock);
+    pthread_mutex_lock(&t->lock);
+    if (c->feed && t->num_watchers == t->watchers_cap && t->watchers_cap < MAX_WATCHERS) {
+        int cap = t->watchers_cap ? t->watchers_cap * 2 : 16;
+        RosterSeat *grown = realloc(t->watchers, (size_t)cap * sizeof(*grown));
+        if (grown) {
+            t->watchers = grown;
+            t->watchers_cap = cap;
         }
+    }
+    if (!c->feed || t->num_watchers == t->watchers_cap) {
+        pthread_mutex_unlock(&t->lock);
+        conn_error(c, "Too many spectators");
+        return -1;
+    }
+    // acknowledged before the first event can be queued behind it
+    if (c->proto == PROTO_BINARY) {
+        uint16_t nid = htons((uint16_t)id);
+        conn_send_op(c, c->gen, OP_WATCHING, &nid, sizeof(nid));
+    } else {
+        char ack[32];
+        snprintf(ack, sizeof(ack), MSG_WATCHING " %d", id);
+        conn_send(c, c->gen, ack);
+    }
+    t->watchers[t->num_watchers++] = (RosterSeat){ .conn = c, .conn_gen = c->gen, .proto = c->proto };
+    roster_update(t);
+    pthread_mutex_unlock(&t->lock);
+    c->watching = t;
+    handshake_done(c);
+    conn_keepalive(c);
+    return 0;
+}
 
-        // Reset players and deal initial two cards
-        for (int i = 0; i < MAX_PLAYERS; ++i) {
-            Player *p = &G.players[i];
-            if (p->alive && p->state == PLAYER_STATE_IN_GAME) {
-                reset_player_round(p);
-                // deal two cards each
-                p->hand[p->hand_size++] = deal_card(G.deck, &G.deck_top);
-                p->hand[p->hand_size++] = deal_card(G.deck, &G.deck_top);
-            }
+// Spectators can only leave (or answer PING)
+static int handle_watch_frame(Conn *c, const FrameView *msg) {
+    int op = c->proto == PROTO_BINARY && msg->len > 0 ? (uint8_t)msg->data[0] : -1;
+    if (c->proto == PROTO_BINARY ? op == OP_QUIT : frame_is(msg, CMD_QUIT)) return -1;
+    if (c->proto == PROTO_BINARY ? op == OP_PONG : frame_is(msg, CMD_PONG)) return 0;
+    conn_error(c, "Spectators can only QUIT");
+    return 0;
+}
+
+// Relay a chat line to everyone else at the table
+static void chat_fanout(Conn *c, GameState *t, const char *from, const char *text, uint32_t len) {
+    char bcast[MAX_PAYLOAD];
+    snprintf(bcast, sizeof(bcast), "%s: %.*s", from, (int)len, text);
+    const Roster *r = roster_get(t);
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        const RosterSeat *s = &r->seats[i];
+        if (s->conn && s->conn != c) send_text_to_player(s, bcast);
+    }
+}
+
+// Queue HIT/STAND/HINT on the seat's mailbox and flag its table for the worker.
+// The worker's doorbell is rung once per reactor batch.
+static void seat_post_action(Conn *c, PlayerAction act) {
+    GameState *t = c->table;
+    if (mailbox_push(&t->players[c->slot].actions, act, monotonic_us()) < 0) {
+        conn_error(c, "Too many pending actions");
+        return;
+    }
+    stats_count(STAT_ACTIONS, 1);
+    Worker *w = &workers[t->worker];
+    int k = (t->id - 1) / num_workers;
+    atomic_fetch_or(&w->ready[k / 64], (uint64_t)1 << (k % 64));
+    c->reactor->kick[t->worker] = 1;
+}
+
+// BET <chips> sets the stake for every round from the next deal on; 0 only
+// reports the bankroll. The worker reads the bet when it deals.
+static void seat_bet(Conn *c, int64_t chips) {
+    Player *p = &c->table->players[c->slot];
+    if (chips != 0) {
+        if (chips < MIN_BET || chips > MAX_BET || chips % BLACKJACK_PAYS_DEN != 0) {
+            char text[64];
+            snprintf(text, sizeof(text), "Bets are %d to %d chips, in steps of %d", MIN_BET, MAX_BET,
+                     BLACKJACK_PAYS_DEN);
+            conn_error(c, text);
+            return;
         }
+        atomic_store_explicit(&p->bet, chips, memory_order_relaxed);
+    }
+    conn_bankroll(c, p);
+}
 
-        // Dealer hand in coordinator (not a player)
-        Card dealer_hand[12]; int dealer_size = 0;
-        dealer_hand[dealer_size++] = deal_card(G.deck, &G.deck_top);
-        dealer_hand[dealer_size++] = deal_card(G.deck, &G.deck_top);
-
-        // Send initial DEAL messages
-        pthread_mutex_lock(&G.lock);
-        for (int i = 0; i < MAX_PLAYERS; ++i) {
-            Player *p = &G.players[i];
-            if (p->alive && p->state == PLAYER_STATE_IN_GAME) {
-                send_hand_to_player(p);
-            }
+// Binary input: one opcode byte, then its operands
+static int handle_binary_frame(Conn *c, const FrameView *msg) {
+    GameState *t = c->table;
+    if (msg->len == 0) return 0;
+    switch ((uint8_t)msg->data[0]) {
+    case OP_HIT:
+        seat_post_action(c, PLAYER_ACTION_HIT);
+        break;
+    case OP_STAND:
+        seat_post_action(c, PLAYER_ACTION_STAND);
+        break;
+    case OP_HINT:
+        seat_post_action(c, PLAYER_ACTION_HINT);
+        break;
+    case OP_DOUBLE:
+        seat_post_action(c, PLAYER_ACTION_DOUBLE);
+        break;
+    case OP_SPLIT:
+        seat_post_action(c, PLAYER_ACTION_SPLIT);
+        break;
+    case OP_BET: {
+        uint32_t chips = 0;
+        if (msg->len >= 5) memcpy(&chips, msg->data + 1, 4);
+        seat_bet(c, ntohl(chips));
+        break;
+    }
+    case OP_QUIT:
+        return -1;
+    case OP_PONG:
+        break; // the read itself proved the connection alive
+    case OP_CHAT:
+        chat_fanout(c, t, t->players[c->slot].name, msg->data + 1, msg->len - 1);
+        break;
+    default:
+        conn_error(c, "Unknown opcode");
+        break;
+    }
+    return 0;
+}
+
+// Dispatch one complete frame. Returns -1 when the connection should close.
+static int handle_frame(Conn *c, const FrameView *msg) {
+    if (c->watching) return handle_watch_frame(c, msg);
+    if (c->slot < 0) {
+        if (frame_is(msg, CMD_WATCH)) return handle_watch(c, msg);
+        if (frame_is(msg, CMD_RESUME)) return handle_resume(c, msg);
+        return handle_join(c, msg);
+    }
+    if (c->proto == PROTO_BINARY) return handle_binary_frame(c, msg);
+    GameState *t = c->table;
+    Player *p = &t->players[c->slot];
+
+    // messages: ACTION HIT|STAND|DOUBLE|SPLIT, HINT, BET, QUIT, CHAT ...
+    if (frame_is(msg, CMD_ACTION)) {
+        FrameView arg;
+        arg.data = frame_arg(msg, CMD_ACTION, &arg.len);
+        PlayerAction act = PLAYER_ACTION_NONE;
+        if (frame_is(&arg, "HIT")) act = PLAYER_ACTION_HIT;
+        else if (frame_is(&arg, "STAND")) act = PLAYER_ACTION_STAND;
+        else if (frame_is(&arg, "DOUBLE")) act = PLAYER_ACTION_DOUBLE;
+        else if (frame_is(&arg, "SPLIT")) act = PLAYER_ACTION_SPLIT;
+        if (act != PLAYER_ACTION_NONE) seat_post_action(c, act);
+    } else if (frame_is(msg, CMD_HINT)) {
+        seat_post_action(c, PLAYER_ACTION_HINT);
+    } else if (frame_is(msg, CMD_BET)) {
+        uint32_t alen;
+        const char *arg = frame_arg(msg, CMD_BET, &alen);
+        char num[24];
+        snprintf(num, sizeof(num), "%.*s", (int)alen, arg);
+        seat_bet(c, strtoll(num, NULL, 10));
+    } else if (frame_is(msg, CMD_QUIT)) {
+        return -1;
+    } else if (frame_is(msg, CMD_PONG)) {
+        // nothing to do: the read itself proved the connection alive
+    } else if (frame_is(msg, CMD_CHAT)) {
+        // broadcast message to others
+        uint32_t plen;
+        const char *payload = frame_arg(msg, CMD_CHAT, &plen);
+        chat_fanout(c, t, p->name, payload, plen);
+    }
+    return 0;
+}
+
+// Pull everything the kernel has for this connection and dispatch each
+// complete length-prefixed frame. Partial frames stay buffered for later.
+static void conn_readable(Conn *c) {
+    for (;;) {
+        ssize_t n = frame_fill(&c->rd, c->fd);
+        stats_count(STAT_RECV_CALLS, 1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            close_conn(c, "disconnected");
+            return;
         }
-        pthread_mutex_unlock(&G.lock);
-
-        // Per-player turns
-        for (int i = 0; i < MAX_PLAYERS; ++i) {
-            Player *p = &G.players[i];
-            if (!(p->alive && p->state == PLAYER_STATE_IN_GAME)) continue;
-            // if busted or stood skip (fresh round none are)
-            while (!p->is_busted && !p->has_stood) {
-                // send YOUR_TURN & REQUEST_ACTION
-                send_msg(p->sockfd, MSG_YOUR_TURN);
-                send_msg(p->sockfd, MSG_REQUEST_ACTION);
-
-                // wait for player's action (timed)
-                struct timespec ts;
-                clock_gettime(CLOCK_REALTIME, &ts);
-                ts.tv_sec += ACTION_TIMEOUT_SEC;
-
-                pthread_mutex_lock(&p->action_lock);
-                p->awaiting_action = 1;
-                while (p->awaiting_action && p->pending_action == PLAYER_ACTION_NONE && p->alive) {
-                    int rc = pthread_cond_timedwait(&p->action_cond, &p->action_lock, &ts);
-                    if (rc == ETIMEDOUT) {
-                        // treat timeout as STAND
-                        p->pending_action = PLAYER_ACTION_STAND;
-                        p->awaiting_action = 0;
-                        break;
-                    }
-                }
-                PlayerAction act = p->pending_action;
-                // reset pending for next time
-                p->pending_action = PLAYER_ACTION_NONE;
-                p->awaiting_action = 0;
-                pthread_mutex_unlock(&p->action_lock);
-
-                if (!p->alive) break;
-
-                if (act == PLAYER_ACTION_HIT) {
-                    Card c = deal_card(G.deck, &G.deck_top);
-                    p->hand[p->hand_size++] = c;
-                    send_card_to_player(p, c);
-                    int hv = hand_value(p->hand, p->hand_size);
-                    if (hv > 21) {
-                        p->is_busted = 1;
-                        send_msg(p->sockfd, MSG_BUSTED);
-                        break;
-                    } else {
-                        // continue loop (player may hit again)
-                        continue;
-                    }
-                } else { // stand
-                    p->has_stood = 1;
-                    break;
-                }
-            } // end while per player
-        } // next player
-
-        // Dealer plays: reveal hole and hit until >=17
-        int dealer_val = hand_value(dealer_hand, dealer_size);
-        // (optional): send dealer hole reveal to all
-        char hole0[4], hole1[4];
-        card_to_str(dealer_hand[0], hole0);
-        card_to_str(dealer_hand[1], hole1);
-        char reveal_msg[MAX_PAYLOAD];
-        snprintf(reveal_msg, sizeof(reveal_msg), "Dealer shows %s %s", hole0, hole1);
-        pthread_mutex_lock(&G.lock);
-        for (int i = 0; i < MAX_PLAYERS; ++i) {
-            Player *p = &G.players[i];
-            if (p->alive && p->state == PLAYER_STATE_IN_GAME) {
-                send_text_to_player(p, reveal_msg);
-            }
+        if (n == 0) {
+            close_conn(c, "disconnected");
+            return;
         }
-        pthread_mutex_unlock(&G.lock);
-
-        // Dealer rules: hit while < 17 (treat Ace appropriately via hand_value)
-        while (dealer_val < 17) {
-            Card c = deal_card(G.deck, &G.deck_top);
-            dealer_hand[dealer_size++] = c;
-            // notify players of dealer card
-            char s[4]; card_to_str(c, s);
-            char dbuf[MAX_PAYLOAD];
-            snprintf(dbuf, sizeof(dbuf), "Dealer hits %s", s);
-            pthread_mutex_lock(&G.lock);
-            for (int i = 0; i < MAX_PLAYERS; ++i) {
-                Player *p = &G.players[i];
-                if (p->alive && p->state == PLAYER_STATE_IN_GAME) {
-                    send_text_to_player(p, dbuf);
-                }
+        stats_count(STAT_RECV_BYTES, (uint64_t)n);
+        c->last_rx_ms = monotonic_ms();
+        c->ping_sent = 0;
+
+        FrameView msg;
+        FrameStatus st;
+        while ((st = frame_next(&c->rd, &msg)) != FRAME_NEED_MORE) {
+            stats_count(STAT_FRAMES_IN, 1);
+            if (st == FRAME_OVERSIZE) {
+                // the payload is skipped in place; the connection stays usable
+                conn_error(c, "Frame too large");
+                continue;
+            }
+            if (handle_frame(c, &msg) < 0) {
+                close_conn(c, c->slot >= 0 ? "quit" : "rejected");
+                return;
             }
-            pthread_mutex_unlock(&G.lock);
-            dealer_val = hand_value(dealer_hand, dealer_size);
         }
+    }
+}
 
-        // Evaluate results and send RESULT to each player
-        pthread_mutex_lock(&G.lock);
-        for (int i = 0; i < MAX_PLAYERS; ++i) {
-            Player *p = &G.players[i];
-            if (!(p->alive && p->state == PLAYER_STATE_IN_GAME)) continue;
-            int pval = hand_value(p->hand, p->hand_size);
-            char result_msg[MAX_PAYLOAD];
-            if (p->is_busted) {
-                snprintf(result_msg, sizeof(result_msg), MSG_RESULT " LOSE %d %d", pval, dealer_val);
-            } else if (dealer_val > 21) {
-                snprintf(result_msg, sizeof(result_msg), MSG_RESULT " WIN %d %d", pval, dealer_val);
-            } else {
-                if (pval > dealer_val) snprintf(result_msg, sizeof(result_msg), MSG_RESULT " WIN %d %d", pval, dealer_val);
-                else if (pval < dealer_val) snprintf(result_msg, sizeof(result_msg), MSG_RESULT " LOSE %d %d", pval, dealer_val);
-                else snprintf(result_msg, sizeof(result_msg), MSG_RESULT " PUSH %d %d", pval, dealer_val);
-            }
-            send_msg(p->sockfd, result_msg);
+// Drain the accept queue. Nothing here waits on the client: JOIN is parsed
+// whenever it arrives, under the lobby deadline. When the handshake list is
+// full the oldest entry makes room, so clients that connect and say nothing
+// can't lock out the ones that answer promptly.
+static void accept_ready(Reactor *r) {
+    for (;;) {
+        struct sockaddr_storage ss;
+        socklen_t slen = sizeof(ss);
+        int client_fd = accept(r->listen_fd, (struct sockaddr*)&ss, &slen);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        if (r->handshakes >= max_handshakes) {
+            stats_count(STAT_HANDSHAKE_EVICTIONS, 1);
+            close_conn(r->hs_head, "evicted");
+        }
+        Conn *c = set_nonblocking(client_fd) == 0 ? conn_alloc(r, client_fd) : NULL;
+        if (!c) {
+            close(client_fd);
+            continue;
+        }
+        stats_count(STAT_ACCEPTS, 1);
+        c->accepted_us = monotonic_us();
+        handshake_add(c);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            perror("epoll_ctl");
+            close_conn(c, "rejected");
+            continue;
         }
-        pthread_mutex_unlock(&G.lock);
+        if (lobby_ms) timer_arm(&r->wheel, &c->idle, lobby_ms);
+    }
+}
+
+// Admin socket: every connection gets one stats report and is closed, so
+// `nc -U <path>` is the whole client. Reading the counters takes no lock.
+static Conn admin_tag; // epoll data for admin_fd; never used as a conn
 
-        // small pause between rounds
-        sleep(2);
+static int admin_listen(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "admin socket path too long: %s\n", path);
+        return -1;
     }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { perror("socket"); return -1; }
+    unlink(path); // left behind by an earlier run
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, ADMIN_BACKLOG) < 0 || set_nonblocking(fd) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
 }
 
-// Accept loop: accepts connections, expects JOIN <name> immediately, then spawns client_reader_thread
-void accept_loop(int port) {
+static void admin_ready(void) {
+    for (;;) {
+        int fd = accept(admin_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) perror("accept");
+            return;
+        }
+        char report[STATS_REPORT_MAX];
+        size_t len = stats_report(report, sizeof(report));
+        // fits an empty socket buffer; never worth blocking the reactor for
+        if (send(fd, report, len, MSG_DONTWAIT) < 0) perror("admin send");
+        close(fd);
+    }
+}
+
+// Bind this reactor's listening socket and epoll set. Runs on the main
+// thread before any reactor starts, so a port in use fails the launch.
+static int reactor_init(Reactor *r, int port) {
     struct sockaddr_in addr;
-    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_fd < 0) { perror("socket"); exit(1); }
+    r->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (r->listen_fd < 0) { perror("socket"); return -1; }
     int opt = 1;
-    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // every reactor gets its own accept queue on the same port
+    if (num_reactors > 1 && setsockopt(r->listen_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("SO_REUSEPORT");
+        return -1;
+    }
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port = htons(port);
 
-    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("bind"); exit(1);
+    if (bind(r->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind"); return -1;
+    }
+    if (listen(r->listen_fd, backlog) < 0) { perror("listen"); return -1; }
+    set_nonblocking(r->listen_fd);
+
+    r->epoll_fd = epoll_create1(0);
+    if (r->epoll_fd < 0) { perror("epoll_create1"); return -1; }
+    struct epoll_event lev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, r->listen_fd, &lev) < 0) { perror("epoll_ctl"); return -1; }
+    r->kick = calloc((size_t)num_workers, sizeof(*r->kick));
+    if (!r->kick) { perror("calloc"); return -1; }
+    timer_wheel_init(&r->wheel);
+    return 0;
+}
+
+// One I/O reactor: accepts connections, expects JOIN <name> as the first
+// frame, then feeds every later frame to handle_frame. Reactor 0 also
+// serves the admin socket.
+void *reactor_main(void *arg) {
+    Reactor *r = arg;
+    stats_attach(r->index);
+    if (r->index == 0 && admin_fd >= 0) {
+        struct epoll_event aev = { .events = EPOLLIN, .data.ptr = &admin_tag };
+        if (epoll_ctl(r->epoll_fd, EPOLL_CTL_ADD, admin_fd, &aev) < 0) perror("epoll_ctl");
     }
-    if (listen(listen_fd, BACKLOG) < 0) { perror("listen"); exit(1); }
-    printf("Server listening on port %d\n", port);
 
+    struct epoll_event events[MAX_EVENTS];
     while (server_running) {
-        struct sockaddr_storage ss;
-        socklen_t slen = sizeof(ss);
-        int client_fd = accept(listen_fd, (struct sockaddr*)&ss, &slen);
-        if (client_fd < 0) {
+        // sleep until I/O or the next idle deadline; wake at least once a second for SIGINT
+        int timeout = timer_wheel_timeout_ms(&r->wheel, monotonic_ms());
+        if (timeout < 0 || timeout > 1000) timeout = 1000;
+        qsbr_offline(r->qsbr);
+        int n = epoll_wait(r->epoll_fd, events, MAX_EVENTS, timeout);
+        qsbr_online(r->qsbr);
+        if (n < 0) {
             if (errno == EINTR) continue;
-            perror("accept"); break;
-        }
-        // set a small recv timeout to detect dead connections quicker (optional)
-        struct timeval tv = { .tv_sec = 0, .tv_usec = 0 }; // default blocking; change if needed
-        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-
-        // immediately expect a JOIN message (within recv_msg)
-        char *msg = NULL;
-        int rr = recv_msg(client_fd, &msg);
-        if (rr <= 0) {
-            close(client_fd);
-            free(msg);
-            continue;
+            perror("epoll_wait"); break;
         }
-        if (strncmp(msg, CMD_JOIN, strlen(CMD_JOIN)) != 0) {
-            // send error and close
-            send_msg(client_fd, MSG_ERROR);
-            send_msg(client_fd, "Expected JOIN");
-            close(client_fd);
-            free(msg);
-            continue;
+        for (int i = 0; i < n; ++i) {
+            Conn *c = events[i].data.ptr;
+            if (!c) {
+                accept_ready(r);
+                continue;
+            }
+            if (c == &admin_tag) {
+                admin_ready();
+                continue;
+            }
+            if (c->fd < 0) continue; // closed earlier in this batch
+            if (events[i].events & EPOLLOUT) conn_writable(c);
+            if (events[i].events & ~EPOLLOUT) conn_readable(c);
         }
-        // parse name
-        char *name = msg + strlen(CMD_JOIN);
-        while (*name == ' ') name++;
-        char pname[MAX_NAME_LEN];
-        strncpy(pname, name, MAX_NAME_LEN-1);
-        pname[MAX_NAME_LEN-1] = '\0';
-        free(msg);
-
-        // assign a slot
-        pthread_mutex_lock(&G.lock);
-        int slot = find_free_slot(&G);
-        if (slot < 0) {
-            pthread_mutex_unlock(&G.lock);
-            send_msg(client_fd, MSG_ERROR);
-            send_msg(client_fd, "Server full");
-            close(client_fd);
-            continue;
+        timer_wheel_advance(&r->wheel, monotonic_ms());
+        // one doorbell per worker for all the actions this batch queued
+        for (int i = 0; i < num_workers; ++i) {
+            if (!r->kick[i]) continue;
+            r->kick[i] = 0;
+            uint64_t one = 1;
+            if (write(workers[i].efd, &one, sizeof(one)) < 0 && errno != EAGAIN) perror("eventfd write");
         }
-        Player *p = &G.players[slot];
-        p->sockfd = client_fd;
-        p->state = PLAYER_STATE_CONNECTED;
-        p->alive = 1;
-        strncpy(p->name, pname, MAX_NAME_LEN-1);
-        p->name[MAX_NAME_LEN-1] = '\0';
-        p->hand_size = 0;
-        p->has_stood = 0;
-        p->is_busted = 0;
-        p->pending_action = PLAYER_ACTION_NONE;
-        p->awaiting_action = 0;
-        send_msg(client_fd, MSG_WELCOME);
-        char welc[MAX_PAYLOAD];
-        snprintf(welc, sizeof(welc), "%s %d", p->name, p->id);
-        send_msg(client_fd, welc);
-
-        // mark as in-game for rounds
-        p->state = PLAYER_STATE_IN_GAME;
-        G.connected_count++;
-        pthread_mutex_unlock(&G.lock);
-
-        // spawn reader thread
-        pthread_create(&p->thread, NULL, client_reader_thread, p);
-        printf("Player %d connected: %s\n", p->id, p->name);
+        // everything this batch queued (WELCOMEs, chat) goes out now
+        flush_pending();
+        qsbr_poll(&roster_qsbr);
     }
+    qsbr_offline(r->qsbr);
+    close(r->epoll_fd);
+    close(r->listen_fd);
+    return NULL;
+}
+
+static void usage(const char *pname) {
+    printf("Usage: %s [-t tables] [-w workers] [-d decks] [-c cut_pct] [-r xoshiro|chacha] [-s seed] [-a stats_socket] [-j journal] [-b ledger] [-B chips] [-T action_sec] [-k keepalive_sec] [-l lobby_sec] [-g grace_sec] [-A acceptors] [-q backlog] [-H handshakes] [-P] [port]\n", pname);
 }
 
 // main
 int main(int argc, char **argv) {
     int port = DEFAULT_PORT;
-    if (argc >= 2) port = atoi(argv[1]);
+    int decks = DEFAULT_DECKS, penetration = DEFAULT_PENETRATION;
+    unsigned action_ms = ACTION_TIMEOUT_SEC * 1000;
+    int64_t starting = STARTING_BANKROLL;
+    int handshakes = DEFAULT_HANDSHAKES;
+    int parallel = 0;
+    RngKind rng_kind = RNG_XOSHIRO;
+    uint64_t seed = rng_entropy();
+    int opt;
+    while ((opt = getopt(argc, argv, "t:w:d:c:r:s:a:j:b:B:T:k:l:g:A:q:H:Ph")) != -1) {
+        switch (opt) {
+        case 't': num_tables = atoi(optarg); break;
+        case 'w': num_workers = atoi(optarg); break;
+        case 'd': decks = atoi(optarg); break;
+        case 'c': penetration = atoi(optarg); break;
+        case 'r':
+            if (rng_parse_kind(optarg, &rng_kind) < 0) { usage(argv[0]); return 1; }
+            break;
+        case 's': seed = strtoull(optarg, NULL, 0); break; // reproducible shoes
+        case 'a': admin_path = optarg; break;
+        case 'j': journal_path = optarg; break;
+        case 'b': ledger_path = optarg; break;
+        case 'B': starting = strtoll(optarg, NULL, 10); break; // chips for new names
+        case 'T': action_ms = (unsigned)atoi(optarg) * 1000; break;
+        case 'k': keepalive_ms = (unsigned)atoi(optarg) * 1000; break;
+        case 'l': lobby_ms = (unsigned)atoi(optarg) * 1000; break;
+        case 'g': grace_ms = (unsigned)atoi(optarg) * 1000; break;
+        case 'A': num_reactors = atoi(optarg); break;
+        case 'q': backlog = atoi(optarg); break;
+        case 'H': handshakes = atoi(optarg); break;
+        case 'P': parallel = 1; break; // every seat plays at once
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind < argc) port = atoi(argv[optind]);
+    if (num_tables < 1) num_tables = 1;
+    if (decks < 1 || decks > MAX_DECKS) decks = DEFAULT_DECKS;
+    if (penetration < 1 || penetration > 100) penetration = DEFAULT_PENETRATION;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu < 1) ncpu = 1;
+    if (num_workers <= 0) num_workers = (int)ncpu;
+    if (num_reactors <= 0) num_reactors = (int)((ncpu + 3) / 4);
+    if (backlog < 1) backlog = DEFAULT_BACKLOG;
+    if (handshakes < 1) handshakes = DEFAULT_HANDSHAKES;
+    max_handshakes = (handshakes + num_reactors - 1) / num_reactors;
     signal(SIGINT, handle_sigint);
-    init_game_state(&G);
-    
-    // Start game loop in a separate thread
-    pthread_t game_thread;
-    pthread_create(&game_thread, NULL, game_loop_wrapper, NULL);
-    
-    accept_loop(port);
+    signal(SIGPIPE, SIG_IGN); // a peer vanishing mid-write is handled via the return code
+
+    // Start the table worker pool; each worker owns every num_workers-th table
+    workers = calloc((size_t)num_workers, sizeof(*workers));
+    reactors = calloc((size_t)num_reactors, sizeof(*reactors));
+    // aligned: each seat's mailbox keeps its indices on their own cache lines
+    tables = aligned_alloc(_Alignof(GameState), (size_t)num_tables * sizeof(*tables));
+    holds = calloc((size_t)num_tables * MAX_PLAYERS, sizeof(*holds));
+    if (!workers || !reactors || !tables || !holds) { perror("calloc"); return 1; }
+    memset(tables, 0, (size_t)num_tables * sizeof(*tables));
+    // QSBR readers: the workers, then the reactors
+    if (qsbr_init(&roster_qsbr, num_workers + num_reactors) < 0) { perror("qsbr_init"); return 1; }
+    if (stats_init(num_reactors + num_workers) < 0) { perror("stats_init"); return 1; }
+    for (int i = 0; i < num_workers; ++i) {
+        Worker *w = &workers[i];
+        w->qsbr = qsbr_reader(&roster_qsbr, i);
+        w->efd = eventfd(0, EFD_NONBLOCK);
+        if (w->efd < 0) { perror("eventfd"); return 1; }
+        timer_wheel_init(&w->wheel);
+        pthread_mutex_init(&w->lock, NULL);
+        int owned = (num_tables - i + num_workers - 1) / num_workers;
+        w->ready_words = (owned + 63) / 64;
+        w->ready = calloc((size_t)w->ready_words + 1, sizeof(*w->ready));
+        if (!w->ready) { perror("calloc"); return 1; }
+    }
+    if (ledger_open(&ledger, ledger_path, starting) < 0) { perror(ledger_path); return 1; }
+    if (ledger_path) printf("Bankrolls on %s\n", ledger_path);
+    Rng streams; // every table gets its own stream split off this one
+    rng_seed(&streams, rng_kind, seed);
+    for (int i = 0; i < num_tables; ++i) {
+        GameState *t = &tables[i];
+        init_game_state(t, i + 1, decks, penetration, &streams);
+        t->worker = i % num_workers;
+        t->wheel = &workers[t->worker].wheel;
+        t->emit = server_emit;
+        t->ledger = &ledger;
+        t->parallel = parallel;
+        if (action_ms) t->action_timeout_ms = action_ms;
+        for (int k = 0; k < MAX_PLAYERS; ++k) {
+            SeatHold *h = &holds[i * MAX_PLAYERS + k];
+            h->table = t;
+            h->seat = k;
+            timer_init(&h->timer, seat_hold_expired, h);
+        }
+    }
+    if (journal_path) {
+        if (journal_open(&journal, journal_path, num_workers) < 0) { perror(journal_path); return 1; }
+        for (int i = 0; i < num_tables; ++i) tables[i].journal = journal_ring(&journal, tables[i].worker);
+        // everything needed to rebuild the shoes; ring 0 is free until its worker starts
+        JournalRecord start = { .at_us = monotonic_us(), .read_us = seed, .type = JR_START,
+                                .seat = JOURNAL_TABLE_WIDE,
+                                .data = { (uint8_t)decks, (uint8_t)penetration, (uint8_t)rng_kind, 0, 0,
+                                          parallel ? JOURNAL_PARALLEL : 0 } };
+        memcpy(&start.data[3], &(uint16_t){ (uint16_t)num_tables }, sizeof(uint16_t));
+        journal_put(journal_ring(&journal, 0), &start);
+        if (journal_start(&journal) < 0) { perror("journal_start"); return 1; }
+        printf("Journal on %s\n", journal_path);
+    }
+    for (int i = 0; i < num_reactors; ++i) {
+        Reactor *r = &reactors[i];
+        r->index = i;
+        r->qsbr = qsbr_reader(&roster_qsbr, num_workers + i);
+        rng_seed(&r->rng, RNG_CHACHA, rng_entropy()); // tokens must not follow from -s
+        if (reactor_init(r, port) < 0) return 1;
+    }
+    printf("Server listening on port %d, %d acceptor%s, backlog %d\n",
+           port, num_reactors, num_reactors == 1 ? "" : "s", backlog);
+    if (admin_path) {
+        admin_fd = admin_listen(admin_path);
+        if (admin_fd < 0) return 1;
+        printf("Stats on %s\n", admin_path);
+    }
+    for (int i = 0; i < num_workers; ++i)
+        pthread_create(&workers[i].thread, NULL, table_worker, &workers[i]);
+    printf("%d tables on %d workers, %d-deck shoes cut at %d%%, %s rng%s\n",
+           num_tables, num_workers, decks, penetration, rng_kind_name(rng_kind),
+           parallel ? ", parallel turns" : "");
+
+    // the main thread is reactor 0
+    for (int i = 1; i < num_reactors; ++i)
+        pthread_create(&reactors[i].thread, NULL, reactor_main, &reactors[i]);
+    reactor_main(&reactors[0]);
     // if server_running becomes 0, drop to cleanup and exit
-    
-    // Wait for game thread to finish
-    pthread_join(game_thread, NULL);
-    
+
+    // Wait for the other reactors and the workers to notice shutdown
+    for (int i = 1; i < num_reactors; ++i) pthread_join(reactors[i].thread, NULL);
+    for (int i = 0; i < num_workers; ++i) pthread_join(workers[i].thread, NULL);
+    if (admin_fd >= 0) {
+        close(admin_fd);
+        unlink(admin_path);
+    }
+    if (journal_path) journal_close(&journal);
+    ledger_close(&ledger);
+
     printf("Server shutting down\n");
-    close(listen_fd);
     return 0;
 }
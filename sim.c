@@ -0,0 +1,278 @@
+// sim.c
+// Offline Monte Carlo simulator. Deals with the server's own shoe, hand
+// values and house rules (deck.c, rules.c) and reports house edge, bust
+// rates and final-total distributions per strategy. Each thread owns its
+// RNG stream, shoes and counters; nothing is shared until the final merge.
+#include "common.h"
+#include "deck.h"
+#include "rules.h"
+#include "rng.h"
+#include "strategy.h"
+#include <stdatomic.h>
+
+#define SIM_HAND 12
+#define DEFAULT_HANDS 10000000ull
+#define DEFAULT_SEATS 6
+#define DEFAULT_DECKS 6
+#define DEFAULT_PENETRATION 75
+#define TOTALS 23 // final totals 0..21, plus 22 = bust
+#define SIM_STAKE BLACKJACK_PAYS_DEN // chips bet per hand, so a 3:2 natural pays whole chips
+
+typedef enum {
+    STRAT_STAND = 0,  // always stand
+    STRAT_DEALER,     // mimic the dealer: hit below 17
+    STRAT_HIT12,      // hit below 12 (never risks a bust)
+    STRAT_RANDOM,     // coin flip below 21
+    STRAT_BASIC,      // the precomputed table the server's HINT uses
+    STRAT_COUNT
+} Strategy;
+
+static const char *strategy_names[STRAT_COUNT] = { "stand", "dealer", "hit12", "random", "basic" };
+
+// Per-thread results; merged by the main thread after join
+typedef struct {
+    uint64_t hands, wins, losses, pushes;
+    uint64_t player_busts, dealer_busts, rounds;
+    uint64_t naturals;
+    uint64_t returned; // chips paid back, stakes included, at SIM_STAKE a hand
+    uint64_t player_totals[TOTALS];
+    uint64_t dealer_totals[TOTALS];
+} SimStats;
+
+typedef struct {
+    _Alignas(64) pthread_t thread;
+    Strategy strategy;
+    uint64_t hands;        // seat-hands to play
+    Rng rng;
+    SimStats stats;
+    atomic_uint_fast64_t done; // progress, read by the main thread
+} SimThread;
+
+static int seats = DEFAULT_SEATS, decks = DEFAULT_DECKS, penetration = DEFAULT_PENETRATION;
+
+static int wants_hit(Strategy s, HandState h, int ncards, Rng *rng) {
+    int v = hand_state_value(h);
+    switch (s) {
+    case STRAT_STAND: return 0;
+    case STRAT_DEALER: return dealer_hits(h);
+    case STRAT_HIT12: return v < 12;
+    case STRAT_RANDOM: return v < 21 && rng_bounded(rng, 2);
+    case STRAT_BASIC: return strategy_lookup(decks, UPCARD_HIDDEN, h, ncards)->hit_best;
+    default: return 0;
+    }
+}
+
+static int total_bucket(int v) {
+    return v > 21 ? 22 : v;
+}
+
+// Same round order as the server: deal two each and two to the dealer,
+// players act in seat order, the dealer always plays out, then settle.
+static void *sim_thread(void *arg) {
+    SimThread *st = arg;
+    SimStats *s = &st->stats;
+    Shoe shoe;
+    HandState hands[MAX_PLAYERS], dealer; // hands are only ever scored, so no card lists
+    int sizes[MAX_PLAYERS];
+    shoe_init(&shoe, decks, penetration);
+    shoe_shuffle(&shoe, &st->rng);
+
+    while (s->hands < st->hands) {
+        if (shoe_past_cut(&shoe)) shoe_shuffle(&shoe, &st->rng);
+        // a round needs at most seats * SIM_HAND + SIM_HAND cards; never run dry mid-round
+        if (shoe.size - shoe.top < (seats + 1) * SIM_HAND) shoe_shuffle(&shoe, &st->rng);
+
+        for (int p = 0; p < seats; ++p) {
+            hands[p] = (HandState){ 0, 0 };
+            hand_state_add(&hands[p], shoe_deal(&shoe));
+            hand_state_add(&hands[p], shoe_deal(&shoe));
+            sizes[p] = 2;
+        }
+        dealer = (HandState){ 0, 0 };
+        hand_state_add(&dealer, shoe_deal(&shoe));
+        hand_state_add(&dealer, shoe_deal(&shoe));
+        int dn = 2;
+
+        for (int p = 0; p < seats; ++p) {
+            while (sizes[p] < SIM_HAND && hand_state_value(hands[p]) <= 21 &&
+                   wants_hit(st->strategy, hands[p], sizes[p], &st->rng)) {
+                hand_state_add(&hands[p], shoe_deal(&shoe));
+                sizes[p]++;
+            }
+        }
+        while (dealer_hits(dealer) && dn < SIM_HAND) {
+            hand_state_add(&dealer, shoe_deal(&shoe));
+            dn++;
+        }
+
+        int dv = hand_state_value(dealer);
+        int dealer_natural = dn == 2 && dv == 21;
+        s->rounds++;
+        s->dealer_totals[total_bucket(dv)]++;
+        if (dv > 21) s->dealer_busts++;
+        for (int p = 0; p < seats; ++p) {
+            int pv = hand_state_value(hands[p]);
+            s->hands++;
+            s->player_totals[total_bucket(pv)]++;
+            if (pv > 21) s->player_busts++;
+            // settled the way the server's settle_round pays
+            int natural = sizes[p] == 2 && pv == 21;
+            Outcome o = natural_outcome(pv, natural, dv, dealer_natural);
+            s->naturals += natural;
+            s->returned += (uint64_t)hand_return(o, natural, SIM_STAKE);
+            switch (o) {
+            case OUTCOME_WIN: s->wins++; break;
+            case OUTCOME_LOSE: s->losses++; break;
+            case OUTCOME_PUSH: s->pushes++; break;
+            }
+        }
+        if ((s->rounds & 0xFFFF) == 0) atomic_store_explicit(&st->done, s->hands, memory_order_relaxed);
+    }
+    atomic_store_explicit(&st->done, s->hands, memory_order_relaxed);
+    return NULL;
+}
+
+static void merge(SimStats *into, const SimStats *from) {
+    into->hands += from->hands;
+    into->wins += from->wins;
+    into->losses += from->losses;
+    into->pushes += from->pushes;
+    into->player_busts += from->player_busts;
+    into->dealer_busts += from->dealer_busts;
+    into->naturals += from->naturals;
+    into->returned += from->returned;
+    into->rounds += from->rounds;
+    for (int i = 0; i < TOTALS; ++i) {
+        into->player_totals[i] += from->player_totals[i];
+        into->dealer_totals[i] += from->dealer_totals[i];
+    }
+}
+
+static double pct(uint64_t n, uint64_t of) {
+    return of ? 100.0 * (double)n / (double)of : 0.0;
+}
+
+static void report(Strategy strat, const SimStats *s, double secs) {
+    // what the house keeps of every chip staked, naturals paid 3:2
+    double staked = (double)s->hands * SIM_STAKE;
+    double edge = staked > 0 ? 100.0 * (staked - (double)s->returned) / staked : 0.0;
+    printf("%-7s %12" PRIu64 " hands %6.2fs  edge %+7.3f%%  win %6.3f%%  lose %6.3f%%  push %6.3f%%"
+           "  natural %6.3f%%  bust %6.3f%%  dealer bust %6.3f%%\n",
+           strategy_names[strat], s->hands, secs, edge, pct(s->wins, s->hands), pct(s->losses, s->hands),
+           pct(s->pushes, s->hands), pct(s->naturals, s->hands), pct(s->player_busts, s->hands),
+           pct(s->dealer_busts, s->rounds));
+}
+
+static void report_totals(const char *who, const uint64_t *totals, uint64_t n) {
+    printf("  %-7s", who);
+    for (int v = 12; v <= 21; ++v) {
+        if (totals[v]) printf(" %d:%.2f%%", v, pct(totals[v], n));
+    }
+    uint64_t low = 0;
+    for (int v = 0; v < 12; ++v) low += totals[v];
+    printf(" <12:%.2f%% bust:%.2f%%\n", pct(low, n), pct(totals[22], n));
+}
+
+// The generator's exact odds off a fresh shoe, in the same buckets
+static void report_exact(const float *odds) {
+    printf("  %-7s", "exact");
+    for (int v = 12; v <= 21; ++v) {
+        if (odds[v] > 0) printf(" %d:%.2f%%", v, 100.0 * odds[v]);
+    }
+    double low = 0;
+    for (int v = 0; v < 12; ++v) low += odds[v];
+    printf(" <12:%.2f%% bust:%.2f%%\n", 100.0 * low, 100.0 * odds[22]);
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *pname) {
+    printf("Usage: %s [-n hands] [-j threads] [-p seats] [-d decks] [-c cut_pct] "
+           "[-s stand|dealer|hit12|random|basic|all] [-r xoshiro|chacha] [-S seed] [-v]\n", pname);
+}
+
+int main(int argc, char **argv) {
+    uint64_t hands = DEFAULT_HANDS;
+    int nthreads = 0, verbose = 0;
+    int only = -1; // every strategy
+    RngKind kind = RNG_XOSHIRO;
+    uint64_t seed = rng_entropy();
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:p:d:c:s:r:S:vh")) != -1) {
+        switch (opt) {
+        case 'n': hands = strtoull(optarg, NULL, 0); break;
+        case 'j': nthreads = atoi(optarg); break;
+        case 'p': seats = atoi(optarg); break;
+        case 'd': decks = atoi(optarg); break;
+        case 'c': penetration = atoi(optarg); break;
+        case 's':
+            if (strcmp(optarg, "all") == 0) { only = -1; break; }
+            for (only = 0; only < STRAT_COUNT && strcmp(optarg, strategy_names[only]) != 0; ++only) {}
+            if (only == STRAT_COUNT) { usage(argv[0]); return 1; }
+            break;
+        case 'r':
+            if (rng_parse_kind(optarg, &kind) < 0) { usage(argv[0]); return 1; }
+            break;
+        case 'S': seed = strtoull(optarg, NULL, 0); break;
+        case 'v': verbose = 1; break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (nthreads <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncpu > 0 ? (int)ncpu : 1;
+    }
+    if (seats < 1 || seats > MAX_PLAYERS) seats = DEFAULT_SEATS;
+    if (decks < 1 || decks > MAX_DECKS) decks = DEFAULT_DECKS;
+    if (penetration < 1 || penetration > 100) penetration = DEFAULT_PENETRATION;
+
+    SimThread *threads = aligned_alloc(_Alignof(SimThread), (size_t)nthreads * sizeof(SimThread));
+    if (!threads) { perror("aligned_alloc"); return 1; }
+    printf("%" PRIu64 " hands per strategy, %d threads, %d seats, %d decks cut at %d%%, %s seed %" PRIu64 "\n",
+           hands, nthreads, seats, decks, penetration, rng_kind_name(kind), seed);
+
+    for (int strat = 0; strat < STRAT_COUNT; ++strat) {
+        if (only >= 0 && strat != only) continue;
+        // same seed for every strategy: they face the same shoes
+        Rng master;
+        rng_seed(&master, kind, seed);
+        double t0 = now_sec();
+        for (int i = 0; i < nthreads; ++i) {
+            SimThread *st = &threads[i];
+            memset(&st->stats, 0, sizeof(st->stats));
+            st->strategy = (Strategy)strat;
+            st->hands = hands / (uint64_t)nthreads + (i < (int)(hands % (uint64_t)nthreads));
+            atomic_init(&st->done, 0);
+            rng_split(&master, &st->rng);
+            pthread_create(&st->thread, NULL, sim_thread, st);
+        }
+        if (verbose) {
+            // progress from the threads' relaxed counters; no locks involved
+            for (;;) {
+                uint64_t done = 0;
+                for (int i = 0; i < nthreads; ++i) done += atomic_load_explicit(&threads[i].done, memory_order_relaxed);
+                fprintf(stderr, "\r%-7s %5.1f%%", strategy_names[strat], pct(done, hands));
+                if (done >= hands) break;
+                struct timespec ts = { 0, 200000000 };
+                nanosleep(&ts, NULL);
+            }
+            fprintf(stderr, "\r");
+        }
+        SimStats total;
+        memset(&total, 0, sizeof(total));
+        for (int i = 0; i < nthreads; ++i) {
+            pthread_join(threads[i].thread, NULL);
+            merge(&total, &threads[i].stats);
+        }
+        report((Strategy)strat, &total, now_sec() - t0);
+        report_totals("player", total.player_totals, total.hands);
+        report_totals("dealer", total.dealer_totals, total.rounds);
+        report_exact(dealer_final_odds[decks - 1][UPCARD_HIDDEN]);
+    }
+    free(threads);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// stats.c
+#include "stats.h"
+#include "timer.h"
+#include <stdarg.h>
+
+_Thread_local Stats *thread_stats;
+
+static Stats *slots;
+static int num_slots;
+static uint64_t started_ms;
+
+static const char *counter_names[STAT_COUNTERS] = {
+    "accepts", "joins", "closes", "frames_in", "actions", "rounds",
+    "recv_calls", "recv_bytes", "send_calls", "send_bytes", "journal_drops",
+    "watch_drops", "idle_closes", "handshake_evictions",
+    "resumes"
+};
+static const char *latency_names[STAT_LATENCIES] = { "join_us", "hit_us", "round_us" };
+
+int stats_init(int nslots) {
+    slots = aligned_alloc(_Alignof(Stats), (size_t)nslots * sizeof(*slots));
+    if (!slots) return -1;
+    memset(slots, 0, (size_t)nslots * sizeof(*slots)); // all-zero is a valid atomic 0 here
+    num_slots = nslots;
+    started_ms = monotonic_ms();
+    return 0;
+}
+
+void stats_attach(int slot) {
+    thread_stats = slot >= 0 && slot < num_slots ? &slots[slot] : NULL;
+}
+
+static size_t append(char *buf, size_t size, size_t len, const char *fmt, ...) {
+    if (len >= size) return len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + len, size - len, fmt, ap);
+    va_end(ap);
+    return n < 0 ? len : len + (size_t)n;
+}
+
+static uint64_t load(const atomic_uint_fast64_t *c) {
+    return atomic_load_explicit(c, memory_order_relaxed);
+}
+
+size_t stats_report(char *buf, size_t size) {
+    size_t len = 0;
+    len = append(buf, size, len, "uptime_s %" PRIu64 "\n", (monotonic_ms() - started_ms) / 1000);
+    for (int k = 0; k < STAT_COUNTERS; ++k) {
+        uint64_t sum = 0;
+        for (int i = 0; i < num_slots; ++i) sum += load(&slots[i].counters[k]);
+        len = append(buf, size, len, "%s %" PRIu64 "\n", counter_names[k], sum);
+    }
+    for (int k = 0; k < STAT_LATENCIES; ++k) {
+        // a writer may be mid-record; that skews one sample, never the layout
+        Hist h;
+        hist_reset(&h);
+        for (int i = 0; i < num_slots; ++i) {
+            const StatHist *s = &slots[i].lat[k];
+            for (int b = 0; b < HIST_BUCKETS; ++b) h.counts[b] += load(&s->counts[b]);
+            h.total += load(&s->total);
+            h.sum += load(&s->sum);
+            uint64_t max = load(&s->max);
+            if (max > h.max) h.max = max;
+        }
+        const char *name = latency_names[k];
+        len = append(buf, size, len, "%s_count %" PRIu64 "\n%s_mean %" PRIu64 "\n", name, h.total, name, hist_mean(&h));
+        len = append(buf, size, len, "%s_p50 %" PRIu64 "\n%s_p99 %" PRIu64 "\n%s_p999 %" PRIu64 "\n%s_max %" PRIu64 "\n",
+                     name, hist_percentile(&h, 50), name, hist_percentile(&h, 99),
+                     name, hist_percentile(&h, 99.9), name, h.max);
+    }
+    return len < size ? len : size - 1;
+}
@@ -0,0 +1,76 @@
+// stats.h
+#ifndef STATS_H
+#define STATS_H
+
+#include "common.h"
+#include "hist.h"
+#include <stdatomic.h>
+
+// Server counters and latency histograms. Every thread records into its own
+// slot and is that slot's only writer, so recording is a relaxed load and
+// store (a plain add on x86: no lock prefix, no shared cache line). A report
+// sums all slots with relaxed loads and may run on any thread.
+
+typedef enum {
+    STAT_ACCEPTS = 0,
+    STAT_JOINS,
+    STAT_CLOSES,
+    STAT_FRAMES_IN,
+    STAT_ACTIONS,     // HIT/STAND/HINT queued on a mailbox
+    STAT_ROUNDS,
+    STAT_RECV_CALLS,
+    STAT_RECV_BYTES,
+    STAT_SEND_CALLS,
+    STAT_SEND_BYTES,
+    STAT_JOURNAL_DROPS, // records lost to a full journal ring
+    STAT_WATCH_DROPS,   // spectators closed for falling too far behind
+    STAT_IDLE_CLOSES,   // no JOIN in time, or no answer to PING
+    STAT_HANDSHAKE_EVICTIONS, // oldest unjoined conn closed to admit a new one
+    STAT_RESUMES,       // held seats taken back with RESUME
+    STAT_COUNTERS
+} StatCounter;
+
+// all in microseconds
+typedef enum {
+    LAT_JOIN = 0,    // accept -> WELCOME queued
+    LAT_HIT,         // HIT frame read -> its CARD queued
+    LAT_ROUND,       // deal -> settle
+    STAT_LATENCIES
+} StatLatency;
+
+// Hist with single-writer atomic fields
+typedef struct {
+    atomic_uint_fast64_t counts[HIST_BUCKETS];
+    atomic_uint_fast64_t total, sum, max;
+} StatHist;
+
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t counters[STAT_COUNTERS];
+    StatHist lat[STAT_LATENCIES];
+} Stats;
+
+extern _Thread_local Stats *thread_stats; // NULL: this thread doesn't record
+
+int stats_init(int nslots);
+void stats_attach(int slot); // the calling thread records into `slot` from now on
+size_t stats_report(char *buf, size_t size); // "name value" lines, totals over all slots
+
+static inline void stat_add(atomic_uint_fast64_t *c, uint64_t n) {
+    atomic_store_explicit(c, atomic_load_explicit(c, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static inline void stats_count(StatCounter k, uint64_t n) {
+    if (thread_stats) stat_add(&thread_stats->counters[k], n);
+}
+
+static inline void stats_latency(StatLatency k, uint64_t us) {
+    if (!thread_stats) return;
+    StatHist *h = &thread_stats->lat[k];
+    stat_add(&h->counts[hist_bucket(us)], 1);
+    stat_add(&h->total, 1);
+    stat_add(&h->sum, us);
+    if (us > atomic_load_explicit(&h->max, memory_order_relaxed))
+        atomic_store_explicit(&h->max, us, memory_order_relaxed);
+}
+
+#endif // STATS_H
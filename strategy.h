@@ -0,0 +1,47 @@
+// strategy.h
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "deck.h"
+
+// Basic-strategy advice and dealer odds for every shoe size. gentables
+// computes them exactly, by memoized recursion over the cards left in the
+// shoe, and the build compiles its output in as strategy_tables.c; a lookup
+// is one array index. An opening hand (two cards) may also double, or split
+// a pair, so it has its own entries.
+
+#define UPCARD_HIDDEN 0     // no dealer card showing, as at our tables
+#define UPCARDS 11          // hidden, then the upcard's points: ace = 1 .. ten = 10
+#define STRATEGY_TOTALS 22  // player hand values 0..21
+#define DEALER_TOTALS 23    // dealer final value 0..21, 22 = bust
+
+typedef enum {
+    MOVE_STAND = 0,
+    MOVE_HIT,
+    MOVE_DOUBLE,
+    MOVE_SPLIT
+} StrategyMove;
+
+typedef struct {
+    float stand;        // expected units won by standing now
+    float hit;          // by hitting, then playing on optimally
+    float dbl;          // opening hands: by doubling, one card at twice the stake
+    float split;        // opening pair of this value (aces for soft 12): by splitting, both hands; else 0
+    uint8_t hit_best;   // basic strategy without doubling or splitting: 1 = hit, 0 = stand
+    uint8_t best;       // opening hands: MOVE_STAND, MOVE_HIT or MOVE_DOUBLE
+    uint8_t split_best; // opening pair: splitting beats every other move
+} StrategyEntry;
+
+// [decks - 1][upcard][opening][soft][value], averaged over every hand of
+// that value with two cards (opening 1) or more (opening 0)
+extern const StrategyEntry strategy_table[MAX_DECKS][UPCARDS][2][2][STRATEGY_TOTALS];
+// [decks - 1][upcard][final], probabilities before any player card is seen
+extern const float dealer_final_odds[MAX_DECKS][UPCARDS][DEALER_TOTALS];
+
+// h, of ncards cards, must not be bust
+static inline const StrategyEntry *strategy_lookup(int decks, int upcard, HandState h, int ncards) {
+    int soft = h.aces && h.hard <= 11;
+    return &strategy_table[decks - 1][upcard][ncards == 2][soft][hand_state_value(h)];
+}
+
+#endif // STRATEGY_H
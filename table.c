@@ -0,0 +1,740 @@
+// table.c
+#include "table.h"
+#include "stats.h"
+#include <math.h>
+
+static void table_on_timer(void *arg);
+
+int table_log = 1;
+
+// The table's stream is split off `streams`
+void init_game_state(GameState *g, int id, int decks, int penetration_pct, Rng *streams) {
+    g->id = id;
+    g->worker = 0;
+    pthread_mutex_init(&g->lock, NULL);
+    g->connected_count = 0;
+    atomic_init(&g->roster, calloc(1, sizeof(Roster)));
+    g->watchers = NULL;
+    g->num_watchers = g->watchers_cap = 0;
+    rng_split(streams, &g->rng);
+    for (int i = 0; i < 2; ++i) {
+        shoe_init(&g->shoes[i], decks, penetration_pct);
+        shoe_shuffle(&g->shoes[i], &g->rng);
+    }
+    g->shoe = &g->shoes[0];
+    g->spare = &g->shoes[1];
+    g->spare_ready = 1;
+    g->phase = PHASE_IDLE;
+    g->round_no = 0;
+    g->turn = -1;
+    g->parallel = 0;
+    g->lane_base = g->lanes = g->lane_rows = g->lane_cap = 0;
+    g->turn_start_us = 0;
+    g->round_start_us = 0;
+    g->action_timeout_ms = ACTION_TIMEOUT_SEC * 1000;
+    g->dealer_size = 0;
+    g->wheel = NULL;
+    g->journal = NULL;
+    g->ledger = NULL;
+    g->ledger_len = 0;
+    g->emit = NULL;
+    timer_init(&g->timer, table_on_timer, g);
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        g->players[i].conn = NULL;
+        g->players[i].conn_gen = 0;
+        g->players[i].id = i+1;
+        g->players[i].state = PLAYER_STATE_EMPTY;
+        g->players[i].alive = 0;
+        g->players[i].proto = 0;
+        g->players[i].account = NULL;
+        g->players[i].session = 0;
+        atomic_init(&g->players[i].bet, MIN_BET);
+        mailbox_init(&g->players[i].actions);
+    }
+    memset(&g->seats, 0, sizeof(g->seats));
+}
+
+int find_free_slot(GameState *g) {
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        if (g->players[i].state == PLAYER_STATE_EMPTY) return i;
+    }
+    return -1;
+}
+
+Roster *table_publish_roster(GameState *t) {
+    Roster *r = calloc(1, sizeof(*r) + (size_t)t->num_watchers * sizeof(r->watchers[0]));
+    if (!r) {
+        perror("calloc");
+        return NULL; // the old snapshot stays; better stale than torn
+    }
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        const Player *p = &t->players[i];
+        if (!p->alive || p->state != PLAYER_STATE_IN_GAME) continue;
+        r->seats[i] = (RosterSeat){ .conn = p->conn, .conn_gen = p->conn_gen, .proto = p->proto };
+        r->seated++;
+    }
+    if (t->num_watchers) memcpy(r->watchers, t->watchers, (size_t)t->num_watchers * sizeof(r->watchers[0]));
+    r->watching = t->num_watchers;
+    return atomic_exchange(&t->roster, r);
+}
+
+// ------------------ event helpers ------------------
+
+static void emit_seat(GameState *t, TableEventType type, int seat) {
+    TableEvent ev = { .type = type, .seat = seat };
+    if (t->emit) t->emit(t, &ev);
+}
+
+static void emit_cards(GameState *t, TableEventType type, int seat, Card c0, Card c1) {
+    TableEvent ev = { .type = type, .seat = seat, .cards = { c0, c1 } };
+    if (t->emit) t->emit(t, &ev);
+}
+
+// Append to the owner's journal; the common fields are filled in here
+static void journal_rec(GameState *t, JournalRecord rec) {
+    if (!t->journal) return;
+    rec.at_us = monotonic_us();
+    rec.round = t->round_no;
+    rec.table = (uint16_t)t->id;
+    rec.shoe_top = (uint16_t)t->shoe->top;
+    if (journal_put(t->journal, &rec) < 0) stats_count(STAT_JOURNAL_DROPS, 1);
+}
+
+static void emit_refused(GameState *t, int seat, const char *why) {
+    TableEvent ev = { .type = EV_REFUSED, .seat = seat, .text = why };
+    if (t->emit) t->emit(t, &ev);
+}
+
+// Queue a bankroll change; ledger_flush() commits everything queued so far
+static void ledger_note(GameState *t, int seat, LedgerType type, int64_t delta) {
+    Account *a = t->seats.account[seat];
+    if (!t->ledger || !a) return;
+    t->ledger_pending[t->ledger_len++] = (LedgerChange){
+        .account = a, .rec = { .delta = delta, .round = t->round_no, .table = (uint16_t)t->id,
+                               .type = (uint8_t)type, .seat = (uint8_t)seat } };
+}
+
+// Commit the queued changes: durable in the log before any balance moves,
+// and before the events that report them are emitted. The outcome of each
+// stays in ledger_pending until the next note. -1 when the log failed.
+static int ledger_flush(GameState *t) {
+    int n = t->ledger_len;
+    t->ledger_len = 0;
+    return n ? ledger_commit(t->ledger, t->ledger_pending, n) : 0;
+}
+
+// Take `amount` from the bankroll the seat is playing from. A seat without
+// one (replay) always has the chips.
+static int take_stake(GameState *t, int seat, int64_t amount) {
+    if (!t->ledger || !t->seats.account[seat]) return 0;
+    ledger_note(t, seat, LR_BET, -amount);
+    ledger_flush(t);
+    return t->ledger_pending[0].refused ? -1 : 0;
+}
+
+static void arm_timer(GameState *t, unsigned ms) {
+    if (t->wheel) timer_arm(t->wheel, &t->timer, ms);
+}
+
+static void cancel_timer(GameState *t) {
+    if (t->wheel) timer_cancel(t->wheel, &t->timer);
+}
+
+// Put the spare shoe in play. Normally the owner's idle tick has shuffled it
+// already and this is just a pointer swap.
+static void swap_shoe(GameState *t) {
+    table_prepare_shoe(t);
+    Shoe *s = t->shoe;
+    t->shoe = t->spare;
+    t->spare = s;
+    t->spare_ready = 0;
+    if (table_log) printf("Table %d: new shoe\n", t->id);
+    journal_rec(t, (JournalRecord){ .type = JR_SHOE, .seat = JOURNAL_TABLE_WIDE });
+}
+
+static void give_card(Hand *h, Card c) {
+    h->cards[h->size++] = c;
+    hand_state_add(&h->hs, c);
+}
+
+static void give_dealer(GameState *t, Card c) {
+    t->dealer_hand[t->dealer_size++] = c;
+    hand_state_add(&t->dealer_hs, c);
+}
+
+static Card draw(GameState *t) {
+    if (t->shoe->top >= t->shoe->size) swap_shoe(t); // ran off the end mid-round
+    return shoe_deal(t->shoe);
+}
+
+static int seat_deciding(const GameState *t, int seat) {
+    const RoundSeats *rs = &t->seats;
+    if (!(rs->active & SEAT_BIT(seat))) return 0;
+    return !((rs->busted | rs->stood) & HAND_BIT(seat, rs->cur_hand[seat]));
+}
+
+// SEAT_BIT of every seat still playing a hand
+static unsigned seats_deciding(const GameState *t) {
+    unsigned deciding = 0;
+    for (unsigned a = t->seats.active; a; a &= a - 1) {
+        int i = __builtin_ctz(a);
+        if (seat_deciding(t, i)) deciding |= SEAT_BIT(i);
+    }
+    return deciding;
+}
+
+// Parallel play deals each seat from its own lane of the shoe. The seats in
+// the round take the cards after the deal in turns, lane k getting every
+// `lanes`-th card from lane_base + k, as if each had drawn one card per row
+// in seat order. So the cards a seat gets depend only on its own moves, not
+// on who acted first. Lanes that run past the end carry on into the spare,
+// up to lane_cap.
+static int lane_pos(const GameState *t, int seat) {
+    return t->lane_base + t->seats.lane_drawn[seat] * t->lanes + t->seats.lane[seat];
+}
+
+// Cards the seat's lane can still give
+static int lane_left(const GameState *t, int seat) {
+    int pos = lane_pos(t, seat);
+    return pos < t->lane_cap ? (t->lane_cap - 1 - pos) / t->lanes + 1 : 0;
+}
+
+// -1 once the lane is past lane_cap; lane_covers() refuses the moves that
+// would get there, so a hand never asks
+static int lane_draw(GameState *t, int seat) {
+    RoundSeats *rs = &t->seats;
+    int pos = lane_pos(t, seat);
+    if (pos >= t->lane_cap || pos - t->shoe->size >= t->spare->size) return -1;
+    if (++rs->lane_drawn[seat] > t->lane_rows) t->lane_rows = rs->lane_drawn[seat];
+    if (pos < t->shoe->size) {
+        if (pos >= t->shoe->top) t->shoe->top = pos + 1;
+        return t->shoe->cards[pos];
+    }
+    t->shoe->top = t->shoe->size;
+    table_prepare_shoe(t);
+    return t->spare->cards[pos - t->shoe->size];
+}
+
+// Every seat is done: the dealer draws on from after the last row a lane used
+static void close_lanes(GameState *t) {
+    int end = t->lane_base + t->lane_rows * t->lanes;
+    if (end <= t->shoe->size) {
+        t->shoe->top = end;
+        return;
+    }
+    if (t->lane_cap <= t->shoe->size) {
+        t->shoe->top = t->shoe->size; // no lane went into the spare; draw() swaps as usual
+        return;
+    }
+    int size = t->shoe->size;
+    swap_shoe(t);
+    t->shoe->top = end - size < t->shoe->size ? end - size : t->shoe->size;
+}
+
+// Deal one card to hand k of the seat, and bust it if need be. A lane with
+// no card left stands the hand.
+static void hit_hand(GameState *t, int seat, int k) {
+    Hand *h = &t->seats.hands[seat][k];
+    int drawn = t->parallel ? lane_draw(t, seat) : draw(t);
+    if (drawn < 0) {
+        t->seats.stood |= (uint16_t)HAND_BIT(seat, k);
+        return;
+    }
+    Card c = (Card)drawn;
+    give_card(h, c);
+    journal_rec(t, (JournalRecord){ .type = JR_CARD, .seat = (uint8_t)seat, .data = { c } });
+    emit_cards(t, EV_CARD, seat, c, 0);
+    if (hand_state_value(h->hs) > 21) {
+        t->seats.busted |= (uint16_t)HAND_BIT(seat, k);
+        journal_rec(t, (JournalRecord){ .type = JR_BUST, .seat = (uint8_t)seat });
+        emit_seat(t, EV_BUSTED, seat);
+    }
+}
+
+// ------------------ round steps ------------------
+
+// Seat everyone connected right now who can cover their bet; later
+// joiners wait for the next round. Every stake goes in one ledger commit.
+// Returns how many were seated.
+static int stake_seats(GameState *t) {
+    const Roster *r = atomic_load_explicit(&t->roster, memory_order_acquire);
+    RoundSeats *rs = &t->seats;
+    unsigned staked = 0, refused = 0;
+    int seated = 0;
+    rs->active = rs->split_aces = 0;
+    rs->busted = rs->stood = 0;
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        Player *p = &t->players[i];
+        if (!r->seats[i].conn) continue;
+        rs->account[i] = p->account;
+        rs->stake[i][0] = atomic_load_explicit(&p->bet, memory_order_relaxed);
+        ledger_note(t, i, LR_BET, -rs->stake[i][0]);
+        staked |= SEAT_BIT(i);
+    }
+    int n = t->ledger_len;
+    int failed = ledger_flush(t) < 0;
+    for (int k = 0; k < n; ++k)
+        if (t->ledger_pending[k].refused) refused |= SEAT_BIT(t->ledger_pending[k].rec.seat);
+    for (; staked; staked &= staked - 1) {
+        int i = __builtin_ctz(staked);
+        if (refused & SEAT_BIT(i)) {
+            if (!(rs->broke & SEAT_BIT(i)))
+                emit_refused(t, i, failed ? "Bankrolls are unavailable; sitting out"
+                                          : "Not enough chips for your bet; sitting out until you can cover it");
+            rs->broke |= (uint8_t)SEAT_BIT(i);
+            continue;
+        }
+        rs->broke &= (uint8_t)~SEAT_BIT(i);
+        rs->num_hands[i] = 1;
+        rs->cur_hand[i] = 0;
+        rs->lane_drawn[i] = 0;
+        rs->hands[i][0] = (Hand){ .size = 0 };
+        rs->active |= (uint8_t)SEAT_BIT(i);
+        seated++;
+    }
+    return seated;
+}
+
+// Hand the stakes back when too few seats could bet for a round
+static void refund_stakes(GameState *t) {
+    RoundSeats *rs = &t->seats;
+    for (unsigned a = rs->active; a; a &= a - 1) {
+        int i = __builtin_ctz(a);
+        ledger_note(t, i, LR_REFUND, rs->stake[i][0]);
+    }
+    ledger_flush(t);
+    rs->active = 0;
+}
+
+// 0 when fewer than MIN_PLAYERS seats covered their bets; nothing is dealt
+// or journaled then, and the stakes go back
+static int deal_round(GameState *t) {
+    RoundSeats *rs = &t->seats;
+    t->round_no++;
+    if (stake_seats(t) < MIN_PLAYERS) {
+        refund_stakes(t);
+        t->round_no--;
+        return 0;
+    }
+    if (table_log) printf("Table %d: starting a new round\n", t->id);
+    t->round_start_us = monotonic_us();
+
+    // The cut card came out last round: switch shoes
+    if (shoe_past_cut(t->shoe)) swap_shoe(t);
+    journal_rec(t, (JournalRecord){ .type = JR_ROUND, .seat = JOURNAL_TABLE_WIDE, .data = { rs->active } });
+
+    // Deal initial two cards
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        if (!(rs->active & SEAT_BIT(i))) continue;
+        give_card(&rs->hands[i][0], draw(t));
+        give_card(&rs->hands[i][0], draw(t));
+    }
+
+    // Dealer hand in coordinator (not a player)
+    t->dealer_size = 0;
+    t->dealer_hs = (HandState){ 0, 0 };
+    give_dealer(t, draw(t));
+    give_dealer(t, draw(t));
+
+    // Send initial DEAL messages
+    for (int i = 0; i < MAX_PLAYERS; ++i) {
+        if (!(rs->active & SEAT_BIT(i))) continue;
+        const Hand *h = &rs->hands[i][0];
+        JournalRecord rec = { .type = JR_DEAL, .seat = (uint8_t)i, .data = { h->cards[0], h->cards[1] } };
+        memcpy(&rec.data[2], &(uint32_t){ (uint32_t)rs->stake[i][0] }, sizeof(uint32_t));
+        journal_rec(t, rec);
+        emit_cards(t, EV_DEAL, i, h->cards[0], h->cards[1]);
+    }
+    journal_rec(t, (JournalRecord){ .type = JR_HOLE, .seat = JOURNAL_TABLE_WIDE,
+                                    .data = { t->dealer_hand[0], t->dealer_hand[1] } });
+    return 1;
+}
+
+// Prompt a seat and start its action deadline. In parallel play every
+// seat has its own deadline and the table timer follows the earliest.
+static void prompt_turn(GameState *t, int seat) {
+    emit_seat(t, EV_TURN, seat);
+    if (t->parallel) t->seats.deadline_ms[seat] = monotonic_ms() + t->action_timeout_ms;
+    else arm_timer(t, t->action_timeout_ms);
+}
+
+// Parallel play: aim the table timer at the first deadline still running
+static void arm_earliest(GameState *t) {
+    uint64_t first = UINT64_MAX;
+    for (unsigned d = seats_deciding(t); d; d &= d - 1) {
+        int i = __builtin_ctz(d);
+        if (t->seats.deadline_ms[i] < first) first = t->seats.deadline_ms[i];
+    }
+    cancel_timer(t);
+    if (first == UINT64_MAX) return;
+    uint64_t now = monotonic_ms();
+    arm_timer(t, first > now ? (unsigned)(first - now) : 0);
+}
+
+// Hand the turn to the next seat still deciding; 0 once every seat is done
+static int next_turn(GameState *t) {
+    for (int i = t->turn + 1; i < MAX_PLAYERS; ++i) {
+        if (seat_deciding(t, i)) {
+            t->turn = i;
+            t->turn_start_us = monotonic_us();
+            prompt_turn(t, i);
+            return 1;
+        }
+    }
+    t->turn = MAX_PLAYERS;
+    return 0;
+}
+
+// Parallel play: give every seat in the round a lane and prompt them all.
+// Lanes may run into the spare unless the deal itself ran out of the last
+// shoe, leaving cards in play in what is the spare now.
+static void open_lanes(GameState *t) {
+    t->turn = MAX_PLAYERS;
+    t->turn_start_us = monotonic_us();
+    t->lane_base = t->shoe->top;
+    t->lanes = 0;
+    t->lane_rows = 0;
+    for (unsigned a = t->seats.active; a; a &= a - 1) {
+        int i = __builtin_ctz(a);
+        t->seats.lane[i] = (uint8_t)t->lanes++;
+        t->seats.lane_drawn[i] = 0;
+    }
+    int dealt = 2 * t->lanes + 2;
+    t->lane_cap = t->shoe->size + (t->lane_base >= dealt ? t->spare->size : 0);
+    for (unsigned d = seats_deciding(t); d; d &= d - 1) prompt_turn(t, __builtin_ctz(d));
+    arm_earliest(t);
+}
+
+// Dealer plays: reveal hole and hit until >=17
+static void dealer_play(GameState *t) {
+    emit_cards(t, EV_DEALER_SHOW, -1, t->dealer_hand[0], t->dealer_hand[1]);
+    while (dealer_hits(t->dealer_hs) && t->dealer_size < MAX_HAND) {
+        Card c = draw(t);
+        give_dealer(t, c);
+        journal_rec(t, (JournalRecord){ .type = JR_DEALER_HIT, .seat = JOURNAL_TABLE_WIDE, .data = { c } });
+        emit_cards(t, EV_DEALER_HIT, -1, c, 0);
+    }
+}
+
+// Evaluate results, pay out and send RESULT for each hand. Payouts are
+// committed in one group before any RESULT goes out.
+static void settle_round(GameState *t) {
+    int dealer_val = hand_state_value(t->dealer_hs);
+    int dealer_natural = t->dealer_size == 2 && dealer_val == 21;
+    RoundSeats *rs = &t->seats;
+    TableEvent results[MAX_PLAYERS * MAX_HANDS];
+    int paid[MAX_PLAYERS * MAX_HANDS]; // the result's entry in ledger_pending, -1 for none
+    int n = 0;
+    for (unsigned a = rs->active; a; a &= a - 1) {
+        int i = __builtin_ctz(a);
+        Account *account = rs->account[i];
+        for (int k = 0; k < rs->num_hands[i]; ++k) {
+            const Hand *h = &rs->hands[i][k];
+            int pval = hand_state_value(h->hs);
+            int natural = rs->num_hands[i] == 1 && h->size == 2 && pval == 21;
+            paid[n] = -1;
+            TableEvent *ev = &results[n++];
+            *ev = (TableEvent){ .type = EV_RESULT, .seat = i, .hand = k, .player_total = pval,
+                                .dealer_total = dealer_val };
+            ev->outcome = natural_outcome(pval, natural, dealer_val, dealer_natural);
+            ev->payout = hand_return(ev->outcome, natural, rs->stake[i][k]);
+            if (account) {
+                ev->balance = ledger_balance(account);
+                if (ev->payout && t->ledger) {
+                    paid[n - 1] = t->ledger_len;
+                    ledger_note(t, i, LR_PAYOUT, ev->payout);
+                }
+            }
+            journal_rec(t, (JournalRecord){ .type = JR_RESULT, .seat = (uint8_t)i, .read_us = (uint64_t)ev->payout,
+                                            .data = { (uint8_t)ev->outcome, (uint8_t)pval, (uint8_t)dealer_val,
+                                                      (uint8_t)k } });
+        }
+    }
+    rs->active = 0;
+    ledger_flush(t);
+    // each hand reports the balance right after its own payout
+    for (int i = 0; i < n; ++i) {
+        const LedgerChange *c = paid[i] >= 0 ? &t->ledger_pending[paid[i]] : NULL;
+        if (c && !c->refused) results[i].balance = c->rec.balance;
+        else if (i > 0 && results[i - 1].seat == results[i].seat) results[i].balance = results[i - 1].balance;
+    }
+    for (int i = 0; i < n; ++i)
+        if (t->emit) t->emit(t, &results[i]);
+    stats_count(STAT_ROUNDS, 1);
+    stats_latency(LAT_ROUND, monotonic_us() - t->round_start_us);
+}
+
+// ------------------ state machine ------------------
+
+// Run the round forward until it needs an action, a seat change or a timer
+void table_advance(GameState *t) {
+    for (;;) {
+        switch (t->phase) {
+        case PHASE_IDLE: {
+            const Roster *r = atomic_load_explicit(&t->roster, memory_order_acquire);
+            if (r->seated < MIN_PLAYERS) return;
+            t->phase = PHASE_DEAL;
+            break;
+        }
+        case PHASE_DEAL:
+            if (!deal_round(t)) {
+                t->phase = PHASE_PAUSE; // try again once the pause is over
+                arm_timer(t, ROUND_PAUSE_MS);
+                return;
+            }
+            t->turn = -1;
+            t->phase = PHASE_PLAYER_TURN;
+            break;
+        case PHASE_PLAYER_TURN:
+            if (t->parallel) {
+                if (t->turn < 0) open_lanes(t);
+                if (seats_deciding(t)) return; // still playing
+                close_lanes(t);
+            } else {
+                // the current seat was prompted already and is still thinking
+                if (t->turn >= 0 && t->turn < MAX_PLAYERS && seat_deciding(t, t->turn)) return;
+                if (next_turn(t)) return;
+            }
+            t->phase = PHASE_DEALER;
+            break;
+        case PHASE_DEALER:
+            dealer_play(t);
+            t->phase = PHASE_SETTLE;
+            break;
+        case PHASE_SETTLE:
+            settle_round(t);
+            t->phase = PHASE_PAUSE;
+            arm_timer(t, ROUND_PAUSE_MS);
+            return;
+        case PHASE_PAUSE:
+            return; // the timer moves us back to IDLE
+        }
+    }
+}
+
+// The seat's current hand is done: play its split hand next, if it has one.
+// A split hand gets its second card only now.
+static void next_hand(GameState *t, int seat) {
+    RoundSeats *rs = &t->seats;
+    while (rs->cur_hand[seat] + 1 < rs->num_hands[seat]) {
+        int k = ++rs->cur_hand[seat];
+        hit_hand(t, seat, k);
+        if (rs->split_aces & SEAT_BIT(seat)) {
+            rs->stood |= (uint16_t)HAND_BIT(seat, k);
+            continue;
+        }
+        prompt_turn(t, seat);
+        return;
+    }
+}
+
+// Move the second card of the pair to a new hand with the same stake
+static void split_hand(GameState *t, int seat) {
+    RoundSeats *rs = &t->seats;
+    Hand *a = &rs->hands[seat][0], *b = &rs->hands[seat][1];
+    *b = (Hand){ .size = 0 };
+    rs->stake[seat][1] = rs->stake[seat][0];
+    give_card(b, a->cards[1]);
+    a->size = 1;
+    a->hs = (HandState){ 0, 0 };
+    hand_state_add(&a->hs, a->cards[0]);
+    rs->num_hands[seat] = 2;
+    int aces = card_points[a->cards[0]] == 1;
+    if (aces) rs->split_aces |= (uint8_t)SEAT_BIT(seat);
+    emit_cards(t, EV_SPLIT, seat, a->cards[0], b->cards[0]);
+    hit_hand(t, seat, 0);
+    if (aces) rs->stood |= (uint16_t)HAND_BIT(seat, 0);
+}
+
+// at_us: when the action was read, 0 for a timeout. DOUBLE and SPLIT have
+// had their extra stake taken already.
+static void apply_action(GameState *t, int seat, PlayerAction act, uint64_t at_us) {
+    RoundSeats *rs = &t->seats;
+    int k = rs->cur_hand[seat];
+    uint16_t bit = (uint16_t)HAND_BIT(seat, k);
+    journal_rec(t, (JournalRecord){ .type = JR_ACTION, .seat = (uint8_t)seat, .read_us = at_us,
+                                    .data = { (uint8_t)act, at_us == 0 } });
+    if (act == PLAYER_ACTION_HIT && rs->hands[seat][k].size < MAX_HAND) {
+        hit_hand(t, seat, k);
+        if (at_us) stats_latency(LAT_HIT, monotonic_us() - at_us);
+        if (!(rs->busted & bit)) {
+            prompt_turn(t, seat); // player may hit again
+            return;
+        }
+    } else if (act == PLAYER_ACTION_DOUBLE) {
+        rs->stake[seat][k] *= 2;
+        hit_hand(t, seat, k);
+        if (!(rs->busted & bit)) rs->stood |= bit;
+    } else if (act == PLAYER_ACTION_SPLIT) {
+        split_hand(t, seat);
+        if (seat_deciding(t, seat)) {
+            prompt_turn(t, seat);
+            return;
+        }
+    } else { // stand
+        rs->stood |= bit;
+    }
+    next_hand(t, seat);
+}
+
+// A two-card hand may double, unless it is a split ace
+static int can_double(const GameState *t, int seat) {
+    const RoundSeats *rs = &t->seats;
+    return rs->hands[seat][rs->cur_hand[seat]].size == 2 && !(rs->split_aces & SEAT_BIT(seat));
+}
+
+// A pair may split, once
+static int can_split(const GameState *t, int seat) {
+    const RoundSeats *rs = &t->seats;
+    const Hand *h = &rs->hands[seat][rs->cur_hand[seat]];
+    return can_double(t, seat) && rs->num_hands[seat] == 1 && h->cards[0] % 13 == h->cards[1] % 13;
+}
+
+// DOUBLE and SPLIT cost another stake and only fit some hands. Returns -1
+// (and tells the seat) when the move is refused; it stays their turn.
+static int raise_stake(GameState *t, int seat, PlayerAction act) {
+    const RoundSeats *rs = &t->seats;
+    int k = rs->cur_hand[seat];
+    if (!can_double(t, seat)) {
+        emit_refused(t, seat, "Only a two-card hand can double or split");
+        return -1;
+    }
+    if (act == PLAYER_ACTION_SPLIT && !can_split(t, seat)) {
+        emit_refused(t, seat, "Only a pair can be split, once");
+        return -1;
+    }
+    if (take_stake(t, seat, rs->stake[seat][k]) < 0) {
+        emit_refused(t, seat, "Not enough chips");
+        return -1;
+    }
+    return 0;
+}
+
+// Parallel play: refuse a draw the seat's lane has no card for. A split
+// hand still waiting for its second card keeps one back.
+static int lane_covers(GameState *t, int seat, PlayerAction act) {
+    const RoundSeats *rs = &t->seats;
+    int need = act == PLAYER_ACTION_SPLIT ? 2 : act == PLAYER_ACTION_HIT || act == PLAYER_ACTION_DOUBLE;
+    if (need == 0) return 1;
+    need += rs->cur_hand[seat] + 1 < rs->num_hands[seat];
+    if (lane_left(t, seat) >= need) return 1;
+    emit_refused(t, seat, "The shoe has no more cards for you; you can only stand");
+    return 0;
+}
+
+// Basic-strategy advice from the precomputed tables. No dealer card is
+// shown at these tables, so it is always the hidden-upcard entry. Only the
+// moves the hand can make are weighed.
+static void give_hint(GameState *t, int seat) {
+    if (!seat_deciding(t, seat)) return;
+    const Hand *h = &t->seats.hands[seat][t->seats.cur_hand[seat]];
+    const StrategyEntry *e = strategy_lookup(t->shoe->size / 52, UPCARD_HIDDEN, h->hs, h->size);
+    int dbl = can_double(t, seat), split = can_split(t, seat);
+    StrategyMove move = split && e->split_best ? MOVE_SPLIT
+                        : dbl ? (StrategyMove)e->best
+                        : e->hit_best ? MOVE_HIT : MOVE_STAND;
+    TableEvent ev = { .type = EV_HINT, .seat = seat, .player_total = hand_state_value(h->hs),
+                      .advice = move, .ev_stand = e->stand, .ev_hit = e->hit,
+                      .ev_double = dbl ? e->dbl : NAN, .ev_split = split ? e->split : NAN };
+    if (t->emit) t->emit(t, &ev);
+}
+
+void table_on_action(GameState *t, int seat, PlayerAction act, uint64_t at_us) {
+    if (act == PLAYER_ACTION_HINT) {
+        give_hint(t, seat);
+        return;
+    }
+    if (t->phase != PHASE_PLAYER_TURN) return;
+    if (t->parallel ? !seat_deciding(t, seat) : seat != t->turn) return; // not their turn
+    if (at_us < t->turn_start_us) return; // typed during an earlier turn
+    if (t->parallel && !lane_covers(t, seat, act)) return;
+    if ((act == PLAYER_ACTION_DOUBLE || act == PLAYER_ACTION_SPLIT) && raise_stake(t, seat, act) < 0) return;
+    if (!t->parallel) cancel_timer(t);
+    apply_action(t, seat, act, at_us);
+    if (t->parallel) arm_earliest(t);
+    table_advance(t);
+}
+
+void table_drain_actions(GameState *t, int seat) {
+    MailboxEntry e;
+    while (mailbox_pop(&t->players[seat].actions, &e))
+        table_on_action(t, seat, (PlayerAction)e.action, e.at_us);
+}
+
+void table_on_join(GameState *t) {
+    if (t->phase == PHASE_IDLE) table_advance(t);
+}
+
+void table_on_leave(GameState *t, int seat) {
+    Player *p = &t->players[seat];
+    // whatever the old occupant still had queued must not reach the next one
+    MailboxEntry e;
+    while (mailbox_pop(&p->actions, &e)) {}
+    t->seats.broke &= (uint8_t)~SEAT_BIT(seat); // a new occupant is told afresh
+    if (!(t->seats.active & SEAT_BIT(seat))) return;
+    t->seats.active &= (uint8_t)~SEAT_BIT(seat); // forfeits the hand
+    journal_rec(t, (JournalRecord){ .type = JR_LEAVE, .seat = (uint8_t)seat });
+    if (t->phase != PHASE_PLAYER_TURN) return;
+    if (t->parallel) {
+        arm_earliest(t);
+        table_advance(t);
+    } else if (seat == t->turn) {
+        cancel_timer(t);
+        table_advance(t);
+    }
+}
+
+void table_on_resume(GameState *t, int seat) {
+    const RoundSeats *rs = &t->seats;
+    int turn = t->phase == PHASE_PLAYER_TURN && t->turn < MAX_PLAYERS ? t->turn : -1;
+    if (t->parallel) turn = t->phase == PHASE_PLAYER_TURN && seat_deciding(t, seat) ? seat : -1;
+    TableEvent ev = { .type = EV_RESYNC, .seat = seat, .round = t->round_no, .turn = turn,
+                      .hand = rs->cur_hand[seat], .hands = rs->hands[seat], .stakes = rs->stake[seat],
+                      .num_hands = rs->active & SEAT_BIT(seat) ? rs->num_hands[seat] : 0 };
+    if (t->emit) t->emit(t, &ev);
+    // the deadline keeps running from the first prompt
+    if (turn == seat && seat_deciding(t, seat)) emit_seat(t, EV_TURN, seat);
+}
+
+int table_prepare_shoe(GameState *t) {
+    if (t->spare_ready) return 0;
+    shoe_shuffle(t->spare, &t->rng);
+    t->spare_ready = 1;
+    return 1;
+}
+
+static void table_on_timer(void *arg) {
+    table_on_timeout(arg);
+}
+
+// Treat a timeout as STAND
+static void expire_seat(GameState *t, int seat) {
+    if (table_log) printf("Table %d: player %d timed out\n", t->id, seat + 1);
+    apply_action(t, seat, PLAYER_ACTION_STAND, 0);
+}
+
+void table_on_seat_timeout(GameState *t, int seat) {
+    if (t->phase != PHASE_PLAYER_TURN) return;
+    if (t->parallel ? !seat_deciding(t, seat) : seat != t->turn) return;
+    if (!t->parallel) cancel_timer(t);
+    expire_seat(t, seat);
+    if (t->parallel) arm_earliest(t);
+    table_advance(t);
+}
+
+void table_on_timeout(GameState *t) {
+    if (t->phase == PHASE_PLAYER_TURN && t->parallel) {
+        // the wheel rounds to its tick, so it may fire a little early
+        uint64_t now = monotonic_ms() + WHEEL_TICK_MS;
+        for (unsigned d = seats_deciding(t); d; d &= d - 1) {
+            int i = __builtin_ctz(d);
+            if (t->seats.deadline_ms[i] <= now) expire_seat(t, i);
+        }
+        arm_earliest(t);
+    } else if (t->phase == PHASE_PLAYER_TURN) {
+        expire_seat(t, t->turn);
+    } else if (t->phase == PHASE_PAUSE) {
+        t->phase = PHASE_IDLE;
+    }
+    table_advance(t);
+}
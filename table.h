@@ -0,0 +1,214 @@
+// table.h
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "common.h"
+#include "deck.h"
+#include "rules.h"
+#include "timer.h"
+#include "mailbox.h"
+#include "strategy.h"
+#include "journal.h"
+#include "ledger.h"
+#include <stdatomic.h>
+
+#define MIN_PLAYERS 2
+#define DEFAULT_DECKS 1
+#define DEFAULT_PENETRATION 75 // cut card position, percent of the shoe
+#define MAX_HAND 12
+#define MAX_HANDS 2 // a seat may split once
+#define MAX_WATCHERS 4096 // spectators per table
+#define ROUND_PAUSE_MS 2000  // pause between rounds
+
+extern int table_log; // print round progress to stdout (default 1)
+
+typedef enum {
+    PLAYER_STATE_EMPTY = 0,
+    PLAYER_STATE_CONNECTED,
+    PLAYER_STATE_IN_GAME,
+    PLAYER_STATE_AWAY,   // connection lost; seat and hand held for RESUME
+} PlayerState;
+
+typedef enum {
+    PLAYER_ACTION_NONE = 0,
+    PLAYER_ACTION_HIT,
+    PLAYER_ACTION_STAND,
+    PLAYER_ACTION_HINT,  // not a move: ask for advice, allowed any time during the hand
+    PLAYER_ACTION_DOUBLE, // double the stake, take one card and stand
+    PLAYER_ACTION_SPLIT  // a pair becomes two hands, each with the original stake
+} PlayerAction;
+
+// Round state machine: IDLE -> DEAL -> PLAYER_TURN (one seat at a time, or
+// every seat at once with `parallel`) -> DEALER -> SETTLE -> PAUSE -> IDLE.
+// Nothing in it ever blocks; it moves on when an action, a seat change or
+// its timer arrives.
+typedef enum {
+    PHASE_IDLE = 0,      // waiting for MIN_PLAYERS
+    PHASE_DEAL,
+    PHASE_PLAYER_TURN,
+    PHASE_DEALER,
+    PHASE_SETTLE,
+    PHASE_PAUSE,         // between rounds
+} RoundPhase;
+
+typedef enum {
+    EV_DEAL,         // seat, cards[0..1]
+    EV_TURN,         // seat is up: YOUR_TURN + REQUEST_ACTION
+    EV_CARD,         // seat, cards[0]
+    EV_BUSTED,       // seat
+    EV_DEALER_SHOW,  // table-wide, cards[0..1]
+    EV_DEALER_HIT,   // table-wide, cards[0]
+    EV_RESULT,       // seat, outcome, player_total, dealer_total
+    EV_HINT,         // seat, advice, player_total, ev_stand, ev_hit, ev_double, ev_split
+    EV_SPLIT,        // seat, cards[0..1]: the first card of each new hand
+    EV_REFUSED,      // seat, text: a bet or move the table would not take
+    EV_RESYNC,       // seat, round, turn, hand, hands: where the round stands, after RESUME
+} TableEventType;
+
+// One hand a seat plays; there are two after a split. Its stake and
+// whether it busted or stood are kept in RoundSeats.
+typedef struct {
+    Card cards[MAX_HAND];
+    uint8_t size;
+    HandState hs; // running value
+} Hand;
+
+typedef struct {
+    TableEventType type;
+    int seat;        // -1 for table-wide events
+    Card cards[2];
+    Outcome outcome;
+    int player_total;
+    int dealer_total;
+    StrategyMove advice;
+    float ev_stand, ev_hit;
+    float ev_double, ev_split; // EV_HINT: NAN when the hand can't make that move
+    int hand;        // EV_RESULT: which of the seat's hands, from 0; EV_RESYNC: the one being played
+    int64_t payout;  // EV_RESULT: chips paid back, stake included
+    int64_t balance; // EV_RESULT: the seat's bankroll afterwards
+    const char *text;
+    const Hand *hands; // EV_RESYNC: the seat's hands this round
+    const int64_t *stakes; // EV_RESYNC: and each one's stake
+    int num_hands;     // EV_RESYNC: 0 when the seat was not dealt in
+    int turn;          // EV_RESYNC: seat whose turn it is, -1 for none
+    uint32_t round;    // EV_RESYNC
+} TableEvent;
+
+typedef struct Conn Conn; // server-side connection, opaque here
+
+typedef struct {
+    // roster, written by the lobby under the table lock
+    Conn *conn;
+    uint32_t conn_gen; // generation of conn this seat belongs to
+    int id; // 1-based
+    char name[MAX_NAME_LEN];
+    PlayerState state;
+    int alive; // 1 = connection open and responsive, 0 = disconnected
+    int proto; // ProtocolMode chosen at JOIN
+    Account *account; // bankroll; NULL plays without one (replay)
+    _Atomic int64_t bet; // stake for each new round, set by BET from the reactor
+    uint64_t session; // secret half of the RESUME token, drawn at JOIN
+
+    Mailbox actions; // HIT/STAND/HINT queued by the reactor, drained by the worker
+} Player;
+
+#define SEAT_BIT(seat) (1u << (seat))
+#define HAND_BIT(seat, hand) (1u << ((seat) * MAX_HANDS + (hand)))
+
+_Static_assert(MAX_PLAYERS * MAX_HANDS <= 16, "a hand mask holds every seat's hands");
+_Static_assert(MAX_PLAYERS * MAX_HANDS <= LEDGER_MAX_CHANGES, "a round's payouts fit one ledger commit");
+
+// Per-round state of every seat, owned by the table's worker. It is split
+// off from Player, whose fields the lobby and reactors write, and laid out
+// as arrays indexed by seat with the flags as bitmasks, so finding who is
+// still playing is a mask test and a round touches a few packed lines.
+typedef struct {
+    uint8_t active;      // SEAT_BIT: dealt into the current round
+    uint8_t split_aces;  // SEAT_BIT: split aces get one card each
+    uint8_t broke;       // SEAT_BIT: told they can't cover their bet, not told again until they can
+    uint16_t busted;     // HAND_BIT
+    uint16_t stood;      // HAND_BIT; also set by DOUBLE
+    uint8_t num_hands[MAX_PLAYERS];
+    uint8_t cur_hand[MAX_PLAYERS];   // the hand being played
+    uint8_t lane[MAX_PLAYERS];       // parallel play: the seat's lane in the shoe
+    uint8_t lane_drawn[MAX_PLAYERS]; // cards taken from it so far
+    int64_t stake[MAX_PLAYERS][MAX_HANDS]; // chips riding on each hand
+    Hand hands[MAX_PLAYERS][MAX_HANDS];
+    uint64_t deadline_ms[MAX_PLAYERS]; // parallel play: monotonic_ms() by which the seat must act
+    Account *account[MAX_PLAYERS]; // the seat's `account` when dealt; pays out at settlement
+} RoundSeats;
+
+// Immutable copy of who is seated, for sending without the table lock.
+// Replaced (never modified) whenever a seat changes.
+typedef struct {
+    Conn *conn;     // NULL: empty, or the player is gone
+    uint32_t conn_gen;
+    int proto;
+} RosterSeat;
+
+typedef struct {
+    int seated;     // seats with a conn
+    RosterSeat seats[MAX_PLAYERS];
+    int watching;   // spectators following the table
+    RosterSeat watchers[];
+} Roster;
+
+// One independent blackjack table. Everything from `seats` on is only
+// touched by the worker thread that owns the table, and starts on its own
+// cache line so the lobby's roster writes never share one with it.
+typedef struct GameState GameState;
+struct GameState {
+    int id; // 1-based
+    int worker; // index of the owning worker
+    Player players[MAX_PLAYERS];
+    pthread_mutex_t lock; // serializes roster writers (the lobby)
+    int connected_count;
+    _Atomic(Roster *) roster; // current snapshot; readers load it without locking
+    RosterSeat *watchers; // spectators, guarded by `lock`; published with the roster
+    int num_watchers, watchers_cap;
+
+    _Alignas(64) RoundSeats seats;
+    RoundPhase phase;
+    uint32_t round_no; // rounds dealt so far, for the journal
+    int turn; // seat currently deciding during PHASE_PLAYER_TURN; MAX_PLAYERS once all were prompted in parallel
+    int parallel; // rules: every seat plays its hand at the same time
+    int lane_base, lanes, lane_rows; // parallel play: where the lanes start, how many, rows used
+    int lane_cap;      // parallel play: lane positions below this are cards the shoe or the spare can give
+    uint64_t turn_start_us; // when `turn` was first prompted; older actions are stale
+    uint64_t round_start_us; // when this round was dealt
+    unsigned action_timeout_ms; // a seat that takes longer stands
+    Card dealer_hand[MAX_HAND];
+    int dealer_size;
+    HandState dealer_hs;
+
+    Shoe *shoe;        // being dealt from
+    Shoe *spare;       // the next shoe, shuffled ahead of time
+    int spare_ready;   // spare is shuffled and can be swapped in
+    Rng rng;           // this table's own stream
+    Shoe shoes[2];
+
+    TimerWheel *wheel; // owner's wheel, NULL when driven without timers
+    JournalRing *journal; // owner's journal ring, NULL when not journaling
+    Ledger *ledger;    // bankrolls, NULL in replay
+    LedgerChange ledger_pending[MAX_PLAYERS * MAX_HANDS]; // this step's changes, committed as one group
+    int ledger_len;
+    Timer timer;       // action deadline or between-round pause; fires table_on_timeout
+    void (*emit)(GameState *t, const TableEvent *ev);
+};
+
+void init_game_state(GameState *g, int id, int decks, int penetration_pct, Rng *streams);
+int find_free_slot(GameState *g);
+Roster *table_publish_roster(GameState *t); // caller holds t->lock; returns the replaced snapshot
+
+// Inputs to the state machine; all must run on the owning worker.
+void table_advance(GameState *t);
+void table_on_join(GameState *t);
+void table_on_leave(GameState *t, int seat);
+void table_on_resume(GameState *t, int seat); // an AWAY seat is back: RESYNC, and its turn again if it was up
+void table_on_action(GameState *t, int seat, PlayerAction act, uint64_t at_us);
+void table_on_timeout(GameState *t); // the table's timer fired; the wheel calls this too
+void table_on_seat_timeout(GameState *t, int seat); // the seat ran out of time and stands (replay)
+void table_drain_actions(GameState *t, int seat); // apply everything queued for the seat
+int table_prepare_shoe(GameState *t); // shuffle the spare shoe if needed; 1 if it did work
+
+#endif // TABLE_H
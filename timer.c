@@ -0,0 +1,155 @@
+// timer.c
+#include "timer.h"
+
+uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void list_unlink(Timer *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+static void list_push(Timer *head, Timer *t) {
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+void timer_init(Timer *t, void (*fn)(void *arg), void *arg) {
+    t->next = t->prev = NULL;
+    t->expires = 0;
+    t->level = t->slot = 0;
+    t->fn = fn;
+    t->arg = arg;
+}
+
+void timer_wheel_init(TimerWheel *w) {
+    for (int l = 0; l < WHEEL_LEVELS; ++l) {
+        for (int i = 0; i < WHEEL_SIZE; ++i) w->slots[l][i].next = w->slots[l][i].prev = &w->slots[l][i];
+        w->occupied[l] = 0;
+    }
+    w->origin_ms = monotonic_ms();
+    w->tick = 0;
+    w->armed = 0;
+}
+
+int timer_armed(const Timer *t) {
+    return t->next != NULL;
+}
+
+// File `t` by how far its deadline is from w->tick. A deadline at or
+// before w->tick goes in the next level-0 slot, so it still fires.
+static void wheel_file(TimerWheel *w, Timer *t) {
+    uint64_t at = t->expires > w->tick ? t->expires : w->tick + 1;
+    uint64_t delta = at - w->tick;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >> (WHEEL_BITS * (level + 1))) level++;
+    if (delta >> (WHEEL_BITS * WHEEL_LEVELS)) at = w->tick + ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    int slot = (int)((at >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+    t->level = (uint8_t)level;
+    t->slot = (uint8_t)slot;
+    list_push(&w->slots[level][slot], t);
+    w->occupied[level] |= (uint64_t)1 << slot;
+}
+
+static void wheel_unfile(TimerWheel *w, Timer *t) {
+    Timer *head = &w->slots[t->level][t->slot];
+    list_unlink(t);
+    if (head->next == head) w->occupied[t->level] &= ~((uint64_t)1 << t->slot);
+}
+
+void timer_arm(TimerWheel *w, Timer *t, unsigned delay_ms) {
+    if (timer_armed(t)) timer_cancel(w, t);
+    // count from "now" rather than w->tick, which lags while the owner sleeps
+    uint64_t now_tick = (monotonic_ms() - w->origin_ms) / WHEEL_TICK_MS;
+    if (now_tick < w->tick) now_tick = w->tick;
+    uint64_t ticks = (delay_ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+    if (ticks == 0) ticks = 1;
+    t->expires = now_tick + ticks;
+    wheel_file(w, t);
+    w->armed++;
+}
+
+void timer_cancel(TimerWheel *w, Timer *t) {
+    if (!timer_armed(t)) return;
+    wheel_unfile(w, t);
+    w->armed--;
+}
+
+// Move every timer in a slot onto `to`
+static void slot_take(TimerWheel *w, int level, int slot, Timer *to) {
+    Timer *head = &w->slots[level][slot];
+    while (head->next != head) {
+        Timer *t = head->next;
+        list_unlink(t);
+        list_push(to, t);
+    }
+    w->occupied[level] &= ~((uint64_t)1 << slot);
+}
+
+void timer_wheel_advance(TimerWheel *w, uint64_t now_ms) {
+    uint64_t target = (now_ms - w->origin_ms) / WHEEL_TICK_MS;
+    if (target <= w->tick) return;
+    if (w->armed == 0) {
+        w->tick = target;
+        return;
+    }
+
+    // collect everything due first so callbacks can re-arm freely
+    Timer due, moved;
+    due.next = due.prev = &due;
+    moved.next = moved.prev = &moved;
+    while (w->tick < target) {
+        uint64_t tick = ++w->tick;
+        // on a level boundary, spread the next slot up over the levels below
+        for (int l = 1; l < WHEEL_LEVELS && !(tick & (((uint64_t)1 << (WHEEL_BITS * l)) - 1)); ++l) {
+            int slot = (int)((tick >> (WHEEL_BITS * l)) & (WHEEL_SIZE - 1));
+            if (!(w->occupied[l] & ((uint64_t)1 << slot))) continue;
+            slot_take(w, l, slot, &moved);
+            while (moved.next != &moved) {
+                Timer *t = moved.next;
+                list_unlink(t);
+                if (t->expires <= tick) list_push(&due, t);
+                else wheel_file(w, t);
+            }
+        }
+        int slot = (int)(tick & (WHEEL_SIZE - 1));
+        if (w->occupied[0] & ((uint64_t)1 << slot)) slot_take(w, 0, slot, &due);
+    }
+
+    while (due.next != &due) {
+        Timer *t = due.next;
+        list_unlink(t);
+        w->armed--;
+        t->fn(t->arg);
+    }
+}
+
+int timer_wheel_timeout_ms(const TimerWheel *w, uint64_t now_ms) {
+    if (w->armed == 0) return -1;
+    // the next level-0 slot in use, or the next cascade if that comes first
+    uint64_t next = UINT64_MAX;
+    unsigned start = (unsigned)((w->tick + 1) & (WHEEL_SIZE - 1));
+    uint64_t bits = w->occupied[0];
+    bits = start ? (bits >> start) | (bits << (WHEEL_SIZE - start)) : bits;
+    if (bits) next = w->tick + 1 + (uint64_t)__builtin_ctzll(bits);
+    for (int l = 1; l < WHEEL_LEVELS; ++l) {
+        if (!w->occupied[l]) continue;
+        uint64_t boundary = ((w->tick >> WHEEL_BITS) + 1) << WHEEL_BITS;
+        if (boundary < next) next = boundary;
+        break;
+    }
+    uint64_t at = w->origin_ms + next * WHEEL_TICK_MS;
+    return at > now_ms ? (int)(at - now_ms) : 0;
+}
@@ -0,0 +1,45 @@
+// timer.h
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "common.h"
+
+#define WHEEL_TICK_MS 10
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)  // slots per level
+#define WHEEL_LEVELS 4                // 64^4 ticks: about 46 hours at 10 ms
+
+// Intrusive timer: embed one in the object that owns the deadline.
+typedef struct Timer {
+    struct Timer *next, *prev;  // NULL while not armed
+    uint64_t expires;           // absolute tick
+    uint8_t level, slot;        // where it is filed while armed
+    void (*fn)(void *arg);
+    void *arg;
+} Timer;
+
+// Hierarchical timer wheel. Level 0 has one slot per tick; each slot of
+// level n spans 64^n ticks and is cascaded into the levels below when the
+// wheel reaches it. Arm and cancel are O(1) whatever the deadline, and
+// a tick only touches the timers that are due or being cascaded. Deadlines
+// past the top level's reach wait in it and are re-filed on each pass.
+// Not thread-safe: each wheel belongs to one thread.
+typedef struct {
+    Timer slots[WHEEL_LEVELS][WHEEL_SIZE]; // circular list heads
+    uint64_t occupied[WHEEL_LEVELS];       // bit per non-empty slot
+    uint64_t origin_ms;         // monotonic time of tick 0
+    uint64_t tick;              // last tick processed
+    int armed;                  // number of timers currently armed
+} TimerWheel;
+
+uint64_t monotonic_ms(void);
+uint64_t monotonic_us(void);
+void timer_init(Timer *t, void (*fn)(void *arg), void *arg);
+void timer_wheel_init(TimerWheel *w);
+void timer_arm(TimerWheel *w, Timer *t, unsigned delay_ms);
+void timer_cancel(TimerWheel *w, Timer *t);
+int timer_armed(const Timer *t);
+void timer_wheel_advance(TimerWheel *w, uint64_t now_ms);      // fires everything due
+int timer_wheel_timeout_ms(const TimerWheel *w, uint64_t now_ms); // -1 when idle
+
+#endif // TIMER_H